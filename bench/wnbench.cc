@@ -0,0 +1,760 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <cstdlib>
+#include <cmath>
+#include <thread>
+
+#include <wnb/core/wordnet.hh>
+#include <wnb/nltk_similarity.hh>
+#include <wnb/similarity_measures.hh>
+#include <wnb/similarity_cache.hh>
+#include <wnb/bfs.hh>
+#include <wnb/std_ext.hh>
+
+using namespace wnb;
+
+namespace
+{
+  typedef std::chrono::steady_clock clock_type;
+
+  double elapsed_ms(clock_type::time_point start)
+  {
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+  }
+
+  void report(const std::string& name, std::vector<double>& times)
+  {
+    std::sort(times.begin(), times.end());
+    double sum = 0;
+    for (std::size_t i = 0; i < times.size(); i++)
+      sum += times[i];
+    std::cout << name << ": min " << times.front() << " ms, median "
+              << times[times.size() / 2] << " ms, mean "
+              << sum / times.size() << " ms (" << times.size() << " runs)"
+              << std::endl;
+  }
+
+  /// Time wordnet construction from the text database
+  void bench_load(const std::string& dir, int runs, unsigned nb_threads)
+  {
+    load_options options;
+    options.nb_threads = nb_threads;
+
+    std::vector<double> times;
+    for (int i = 0; i < runs; i++)
+    {
+      clock_type::time_point start = clock_type::now();
+      wordnet wn(dir, options);
+      times.push_back(elapsed_ms(start));
+    }
+    report("load", times);
+  }
+
+  /// Time wordnet construction from a binary snapshot
+  void bench_snapshot(const std::string& dir, const std::string& fn, int runs)
+  {
+    {
+      wordnet wn(dir);
+      wn.save_snapshot(fn);
+    }
+
+    std::vector<double> times;
+    for (int i = 0; i < runs; i++)
+    {
+      clock_type::time_point start = clock_type::now();
+      wordnet wn(from_snapshot, fn);
+      times.push_back(elapsed_ms(start));
+    }
+    report("snapshot load", times);
+  }
+
+  /// Time lemma lookups (hits and misses, in random order):
+  /// binary search over index_list vs wordnet::find_indexes
+  void bench_lookup(const std::string& dir, int runs)
+  {
+    wordnet wn(dir);
+
+    std::vector<std::string> words;
+    for (std::size_t k = 0; k < wn.index_list.size(); k++)
+    {
+      words.push_back(wn.index_list[k].lemma.to_string());
+      words.push_back(words.back() + "s");
+    }
+    std::shuffle(words.begin(), words.end(), std::mt19937(42));
+
+    std::vector<double> times_bs, times_hash;
+    std::size_t found_bs = 0, found_hash = 0;
+    for (int i = 0; i < runs; i++)
+    {
+      clock_type::time_point start = clock_type::now();
+      for (std::size_t k = 0; k < words.size(); k++)
+      {
+        wnb::index light_index;
+        light_index.lemma = wnb::string_ref(words[k]);
+        std::pair<std::vector<wnb::index>::iterator,
+                  std::vector<wnb::index>::iterator> bounds =
+          std::equal_range(wn.index_list.begin(), wn.index_list.end(), light_index);
+        found_bs += bounds.second - bounds.first;
+      }
+      times_bs.push_back(elapsed_ms(start));
+
+      start = clock_type::now();
+      for (std::size_t k = 0; k < words.size(); k++)
+        found_hash += wn.find_indexes(wnb::string_ref(words[k])).size();
+      times_hash.push_back(elapsed_ms(start));
+    }
+    if (found_bs != found_hash)
+      std::cerr << "lookup mismatch" << std::endl;
+    std::cout << words.size() << " lookups" << std::endl;
+    report("equal_range", times_bs);
+    report("find_indexes", times_hash);
+  }
+
+  /// Time synset queries (lemmas and inflected forms, in random order):
+  /// get_synsets copies vs get_synset_ids into a reused buffer
+  void bench_synsets(const std::string& dir, int runs)
+  {
+    wordnet wn(dir);
+
+    std::vector<std::string> words;
+    for (std::size_t k = 0; k < wn.index_list.size(); k += 4)
+    {
+      words.push_back(wn.index_list[k].lemma.to_string());
+      words.push_back(words.back() + "s");
+    }
+    std::shuffle(words.begin(), words.end(), std::mt19937(42));
+
+    std::vector<double> times_copy, times_ids, times_lemma;
+    std::size_t found_copy = 0, found_ids = 0;
+    std::vector<int> ids;
+    for (int i = 0; i < runs; i++)
+    {
+      clock_type::time_point start = clock_type::now();
+      for (std::size_t k = 0; k < words.size(); k++)
+        found_copy += wn.get_synsets(words[k]).size();
+      times_copy.push_back(elapsed_ms(start));
+
+      start = clock_type::now();
+      for (std::size_t k = 0; k < words.size(); k++)
+      {
+        ids.clear();
+        wn.get_synset_ids(words[k], ids);
+        found_ids += ids.size();
+      }
+      times_ids.push_back(elapsed_ms(start));
+
+      start = clock_type::now();
+      for (std::size_t k = 0; k < words.size(); k++)
+      {
+        ids.clear();
+        wn.get_lemma_synset_ids(wnb::string_ref(words[k]), ids);
+      }
+      times_lemma.push_back(elapsed_ms(start));
+    }
+    if (found_copy != found_ids)
+      std::cerr << "synsets mismatch" << std::endl;
+    std::cout << words.size() << " queries" << std::endl;
+    report("get_synsets", times_copy);
+    report("get_synset_ids", times_ids);
+    report("get_lemma_synset_ids", times_lemma);
+  }
+
+  /// Time morphword on inflected forms of the lemmas (in random order),
+  /// for each pos and for all of them
+  void bench_morph(const std::string& dir, int runs)
+  {
+    wordnet wn(dir);
+
+    const char* endings[] = { "s", "es", "ies", "ed", "ing", "er", "est", "men" };
+    std::vector<std::string> words;
+    for (std::size_t k = 0; k < wn.index_list.size(); k += 8)
+      for (std::size_t e = 0; e < 8; e++)
+        words.push_back(wn.index_list[k].lemma.to_string() + endings[e]);
+    std::shuffle(words.begin(), words.end(), std::mt19937(42));
+
+    pos_t       poss[]  = { N, V, A, UNKNOWN };
+    const char* names[] = { "morphword noun", "morphword verb",
+                            "morphword adj", "morphword any" };
+    for (std::size_t p = 0; p < 4; p++)
+    {
+      std::vector<double> times;
+      std::size_t found = 0;
+      for (int r = 0; r < runs; r++)
+      {
+        found = 0;
+        clock_type::time_point start = clock_type::now();
+        for (std::size_t k = 0; k < words.size(); k++)
+          found += !wn.morphword(words[k], poss[p]).empty();
+        times.push_back(elapsed_ms(start));
+      }
+      std::cout << words.size() << " words, " << found << " found" << std::endl;
+      report(names[p], times);
+    }
+
+    // every pos of each word (as wntest), one call per pos or all at once
+    std::vector<double> times_each, times_all;
+    std::size_t found_each = 0, found_all = 0;
+    for (int r = 0; r < runs; r++)
+    {
+      found_each = found_all = 0;
+      clock_type::time_point start = clock_type::now();
+      for (std::size_t k = 0; k < words.size(); k++)
+        for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+          found_each += !wn.morphword(words[k], (pos_t) p).empty();
+      times_each.push_back(elapsed_ms(start));
+
+      std::string bases[POS_ARRAY_SIZE];
+      start = clock_type::now();
+      for (std::size_t k = 0; k < words.size(); k++)
+      {
+        wn.morphwords(words[k], bases);
+        for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+          found_all += !bases[p].empty();
+      }
+      times_all.push_back(elapsed_ms(start));
+    }
+    std::cout << words.size() << " words, " << found_each << " / "
+              << found_all << " found" << std::endl;
+    report("morphword every pos", times_each);
+    report("morphwords", times_all);
+
+    // Zipf like token stream (rank log-uniform), without and with a
+    // warmed morphword cache
+    std::uniform_real_distribution<double> uniform(0, std::log(double(words.size())));
+    std::mt19937 gen(42);
+    std::vector<std::string> tokens(1000000);
+    for (std::size_t k = 0; k < tokens.size(); k++)
+      tokens[k] = words[std::size_t(std::exp(uniform(gen))) - 1];
+    std::vector<std::string> frequent(words.begin(), words.begin() + 2000);
+
+    std::vector<double> times, times_cached;
+    morph_cache::statistics st = { 0, 0, 0 };
+    for (int r = 0; r < runs; r++)
+    {
+      wn.set_morph_cache(0);
+      clock_type::time_point start = clock_type::now();
+      for (std::size_t k = 0; k < tokens.size(); k++)
+        wn.morphword(tokens[k]);
+      times.push_back(elapsed_ms(start));
+
+      wn.set_morph_cache(16384);
+      wn.warm_morph_cache(frequent);
+      start = clock_type::now();
+      for (std::size_t k = 0; k < tokens.size(); k++)
+        wn.morphword(tokens[k]);
+      times_cached.push_back(elapsed_ms(start));
+      st = wn.morph_cache_stats();
+    }
+    std::cout << tokens.size() << " tokens, " << st.hits << " hits, "
+              << st.misses << " misses, " << st.evictions << " evictions"
+              << std::endl;
+    report("morphword stream", times);
+    report("morphword stream (cached)", times_cached);
+  }
+
+  /// Time path similarity of random noun pairs (graph traversals)
+  void bench_similarity(const std::string& dir, int runs)
+  {
+    wordnet wn(dir);
+    clock_type::time_point built = clock_type::now();
+    nltk_similarity similarity(wn);
+    std::cout << "nltk_similarity construction: " << elapsed_ms(built) << " ms"
+              << std::endl;
+
+    std::size_t nb_nouns = wn.info.get_indice_offset(V);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> pick(0, nb_nouns - 1);
+    std::vector<std::pair<std::size_t, std::size_t> > pairs(100000);
+    for (std::size_t k = 0; k < pairs.size(); k++)
+      pairs[k] = std::make_pair(pick(gen), pick(gen));
+
+    std::vector<double> times;
+    double sum = 0;
+    for (int r = 0; r < runs; r++)
+    {
+      sum = 0;
+      clock_type::time_point start = clock_type::now();
+      for (std::size_t k = 0; k < pairs.size(); k++)
+        sum += similarity(wn.get_synset(pairs[k].first),
+                          wn.get_synset(pairs[k].second));
+      times.push_back(elapsed_ms(start));
+    }
+    std::cout << pairs.size() << " pairs, sum " << sum << std::endl;
+    report("path similarity", times);
+
+    // candidate filtering: paths of at most 6 edges
+    std::vector<double> times_bounded;
+    std::size_t in_range = 0;
+    for (int r = 0; r < runs; r++)
+    {
+      in_range = 0;
+      clock_type::time_point start = clock_type::now();
+      for (std::size_t k = 0; k < pairs.size(); k++)
+        in_range += similarity(wn.get_synset(pairs[k].first),
+                               wn.get_synset(pairs[k].second), 6) > 0;
+      times_bounded.push_back(elapsed_ms(start));
+    }
+    std::cout << in_range << " pairs within 6 edges" << std::endl;
+    report("path similarity (max depth 6)", times_bounded);
+
+    // one vs many: a few query synsets against every synset of the index
+    std::vector<int> queries, candidates;
+    for (std::size_t k = 0; k < 4; k++)
+      queries.push_back(pick(gen));
+    for (std::size_t i = 0; i < wn.index_list.size(); i++)
+      candidates.insert(candidates.end(), wn.index_list[i].synset_ids.begin(),
+                        wn.index_list[i].synset_ids.end());
+
+    std::vector<double> times_pairs, times_batch;
+    std::vector<float> best;
+    for (int r = 0; r < runs; r++)
+    {
+      clock_type::time_point start = clock_type::now();
+      best.assign(candidates.size(), -1);
+      for (std::size_t i = 0; i < queries.size(); i++)
+        for (std::size_t j = 0; j < candidates.size(); j++)
+          best[j] = std::max(best[j], similarity(wn.get_synset(queries[i]),
+                                                 wn.get_synset(candidates[j])));
+      times_pairs.push_back(elapsed_ms(start));
+
+      start = clock_type::now();
+      similarity.max_similarities(queries, candidates, best);
+      times_batch.push_back(elapsed_ms(start));
+    }
+    std::cout << queries.size() << " queries x " << candidates.size()
+              << " candidates" << std::endl;
+    report("pairwise", times_pairs);
+    report("max_similarities", times_batch);
+
+    // top k: scoring every synset vs most_similar
+    std::vector<int> all_synsets(num_vertices(wn.wordnet_graph));
+    for (std::size_t i = 0; i < all_synsets.size(); i++)
+      all_synsets[i] = i;
+    std::vector<int> top_queries(100);
+    for (std::size_t k = 0; k < top_queries.size(); k++)
+      top_queries[k] = pick(gen);
+
+    const std::size_t k = 10;
+    std::vector<double> times_scan, times_top;
+    std::vector<float> scores;
+    std::vector<nltk_similarity::synset_score> top;
+    std::vector<int> order;
+    std::size_t nb_scan = 0, nb_top = 0;
+    for (int r = 0; r < runs; r++)
+    {
+      nb_scan = nb_top = 0;
+      clock_type::time_point start = clock_type::now();
+      for (std::size_t q = 0; q < top_queries.size(); q++)
+      {
+        std::vector<int> query(1, top_queries[q]);
+        similarity.similarities(query, all_synsets, scores);
+        scores[top_queries[q]] = -1;
+        order = all_synsets;
+        std::partial_sort(order.begin(), order.begin() + k, order.end(),
+                          [&scores](int a, int b)
+                          {
+                            return scores[a] > scores[b]
+                              || (scores[a] == scores[b] && a < b);
+                          });
+        for (std::size_t i = 0; i < k; i++)
+          nb_scan += scores[order[i]] > 0;
+      }
+      times_scan.push_back(elapsed_ms(start));
+
+      start = clock_type::now();
+      for (std::size_t q = 0; q < top_queries.size(); q++)
+      {
+        similarity.most_similar(wn.get_synset(top_queries[q]), k, top);
+        nb_top += top.size();
+      }
+      times_top.push_back(elapsed_ms(start));
+    }
+    if (nb_scan != nb_top)
+      std::cerr << "top k mismatch" << std::endl;
+    std::cout << top_queries.size() << " top " << k << " queries, "
+              << nb_top << " results" << std::endl;
+    report("similarities + partial_sort", times_scan);
+    report("most_similar", times_top);
+  }
+
+  /// Time Wu-Palmer, Leacock-Chodorow and information content measures on
+  /// random noun pairs
+  void bench_measures(const std::string& dir, int runs)
+  {
+    wordnet wn(dir);
+    clock_type::time_point built = clock_type::now();
+    similarity_measures measures(wn);
+    std::cout << "similarity_measures construction: " << elapsed_ms(built)
+              << " ms" << std::endl;
+
+    std::size_t nb_nouns = wn.info.get_indice_offset(V);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> pick(0, nb_nouns - 1);
+    std::vector<std::pair<std::size_t, std::size_t> > pairs(100000);
+    for (std::size_t k = 0; k < pairs.size(); k++)
+      pairs[k] = std::make_pair(pick(gen), pick(gen));
+
+    typedef double (similarity_measures::*measure)(const synset&, const synset&) const;
+    const char* names[]   = { "wup", "lch", "resnik", "lin", "jcn" };
+    measure     measure_fns[] = { &similarity_measures::wup, &similarity_measures::lch,
+                                  &similarity_measures::resnik, &similarity_measures::lin,
+                                  &similarity_measures::jcn };
+    for (std::size_t m = 0; m < 5; m++)
+    {
+      std::vector<double> times;
+      double sum = 0;
+      for (int r = 0; r < runs; r++)
+      {
+        sum = 0;
+        clock_type::time_point start = clock_type::now();
+        for (std::size_t k = 0; k < pairs.size(); k++)
+          sum += (measures.*measure_fns[m])(wn.get_synset(pairs[k].first),
+                                            wn.get_synset(pairs[k].second));
+        times.push_back(elapsed_ms(start));
+      }
+      std::cout << pairs.size() << " pairs, sum " << sum << std::endl;
+      report(names[m], times);
+    }
+  }
+
+  /// Time path and Wu-Palmer similarities of skewed pair traffic (a few
+  /// pairs asked often, most rarely), without and with a similarity_cache
+  void bench_cache(const std::string& dir, int runs)
+  {
+    wordnet wn(dir);
+    nltk_similarity     similarity(wn);
+    similarity_measures measures(wn);
+
+    std::size_t nb_nouns = wn.info.get_indice_offset(V);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> pick(0, nb_nouns - 1);
+    std::vector<std::pair<std::size_t, std::size_t> > pool(100000);
+    for (std::size_t k = 0; k < pool.size(); k++)
+      pool[k] = std::make_pair(pick(gen), pick(gen));
+
+    // pool[k] drawn with a probability decreasing with k
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::vector<std::pair<std::size_t, std::size_t> > pairs(1000000);
+    for (std::size_t k = 0; k < pairs.size(); k++)
+    {
+      double u = uniform(gen);
+      pairs[k] = pool[std::size_t(pool.size() * u * u * u * u)];
+    }
+
+    auto wup = [&measures](const synset& s1, const synset& s2)
+      {
+        return measures.wup(s1, s2);
+      };
+
+    std::vector<double> times_path, times_path_cached, times_wup, times_wup_cached;
+    double sum = 0, sum_cached = 0, sum_wup = 0, sum_wup_cached = 0;
+    similarity_cache<float>::statistics st = { 0, 0, 0 };
+    for (int r = 0; r < runs; r++)
+    {
+      similarity_cache<float>  path_cache(65536);
+      similarity_cache<double> wup_cache(65536);
+
+      sum = 0;
+      clock_type::time_point start = clock_type::now();
+      for (std::size_t k = 0; k < pairs.size(); k++)
+        sum += similarity(wn.get_synset(pairs[k].first),
+                          wn.get_synset(pairs[k].second));
+      times_path.push_back(elapsed_ms(start));
+
+      sum_cached = 0;
+      start = clock_type::now();
+      for (std::size_t k = 0; k < pairs.size(); k++)
+        sum_cached += path_cache(wn.get_synset(pairs[k].first),
+                                 wn.get_synset(pairs[k].second), similarity);
+      times_path_cached.push_back(elapsed_ms(start));
+
+      sum_wup = 0;
+      start = clock_type::now();
+      for (std::size_t k = 0; k < pairs.size(); k++)
+        sum_wup += wup(wn.get_synset(pairs[k].first), wn.get_synset(pairs[k].second));
+      times_wup.push_back(elapsed_ms(start));
+
+      sum_wup_cached = 0;
+      start = clock_type::now();
+      for (std::size_t k = 0; k < pairs.size(); k++)
+        sum_wup_cached += wup_cache(wn.get_synset(pairs[k].first),
+                                    wn.get_synset(pairs[k].second), wup);
+      times_wup_cached.push_back(elapsed_ms(start));
+
+      st = path_cache.stats();
+    }
+    if (sum != sum_cached || sum_wup != sum_wup_cached)
+      std::cerr << "cached similarities mismatch" << std::endl;
+    std::cout << pairs.size() << " queries of " << pool.size() << " pairs, "
+              << st.hits << " hits, " << st.misses << " misses, "
+              << st.evictions << " evictions" << std::endl;
+    report("path similarity", times_path);
+    report("path similarity (cached)", times_path_cached);
+    report("wup", times_wup);
+    report("wup (cached)", times_wup_cached);
+  }
+
+  /// Time depth bounded hypernym/hyponym distances of random noun pairs:
+  /// breadth_first_search with distance_recorder (exceptions, maps per
+  /// query) vs distance_search
+  void bench_bfs(const std::string& dir, int runs)
+  {
+    typedef wordnet::graph graph;
+    typedef boost::filtered_graph<graph, bfs::hypo_hyper_edge<graph> > hypo_hyper;
+
+    wordnet wn(dir);
+    const graph& g = wn.wordnet_graph;
+    hypo_hyper fg(g, bfs::hypo_hyper_edge<graph>(g));
+    bfs::distance_search<graph> search(g, bfs::hypo_hyper_edge<graph>(g));
+
+    std::size_t nb_nouns = wn.info.get_indice_offset(V);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> pick(0, nb_nouns - 1);
+    std::vector<std::pair<std::size_t, std::size_t> > pairs(2000);
+    for (std::size_t k = 0; k < pairs.size(); k++)
+      pairs[k] = std::make_pair(pick(gen), pick(gen));
+
+    const int max_depth = 16;
+    std::vector<double> times_visitor, times_search, times_bidirectional;
+    long sum_visitor = 0, sum_search = 0, sum_bidirectional = 0;
+    for (int r = 0; r < runs; r++)
+    {
+      sum_visitor = sum_search = sum_bidirectional = 0;
+      clock_type::time_point start = clock_type::now();
+      for (std::size_t k = 0; k < pairs.size(); k++)
+      {
+        int d = (pairs[k].first == pairs[k].second) ? 0 : -1;
+        std::vector<int> dist(num_vertices(g), 0);
+        try
+        {
+          boost::breadth_first_search(fg, pairs[k].first,
+            boost::visitor(bfs::record_distance(
+              boost::make_iterator_property_map(dist.begin(),
+                                                get(boost::vertex_index, fg)),
+              wn.get_synset(pairs[k].second), max_depth)));
+        }
+        catch (int found)
+        {
+          d = (found <= max_depth) ? found : -1;
+        }
+        sum_visitor += d;
+      }
+      times_visitor.push_back(elapsed_ms(start));
+
+      start = clock_type::now();
+      for (std::size_t k = 0; k < pairs.size(); k++)
+        sum_search += search.distance(pairs[k].first, pairs[k].second, max_depth);
+      times_search.push_back(elapsed_ms(start));
+
+      start = clock_type::now();
+      for (std::size_t k = 0; k < pairs.size(); k++)
+        sum_bidirectional += search.bidirectional_distance(pairs[k].first,
+                                                           pairs[k].second,
+                                                           max_depth);
+      times_bidirectional.push_back(elapsed_ms(start));
+    }
+    if (sum_visitor != sum_search || sum_search != sum_bidirectional)
+      std::cerr << "distances mismatch" << std::endl;
+    std::cout << pairs.size() << " pairs, max depth " << max_depth
+              << ", sum " << sum_search << std::endl;
+    report("distance_recorder", times_visitor);
+    report("distance_search", times_search);
+    report("distance_search (bidirectional)", times_bidirectional);
+  }
+
+  /// Time rank_words of the whole vocabulary against "dog", for 1, 2, 4...
+  /// max_threads threads
+  void bench_rank(const std::string& dir, int runs, unsigned max_threads)
+  {
+    wordnet wn(dir);
+    nltk_similarity similarity(wn);
+
+    std::vector<std::string> vocabulary;
+    for (std::size_t i = 0; i < wn.index_list.size(); i++)
+      if (i == 0 || wn.index_list[i].lemma != wn.index_list[i - 1].lemma)
+        vocabulary.push_back(wn.index_list[i].lemma.to_string());
+
+    std::vector<word_score> reference;
+    for (unsigned nb_threads = 1; nb_threads <= max_threads; nb_threads *= 2)
+    {
+      std::vector<double> times;
+      std::vector<word_score> ranking;
+      for (int r = 0; r < runs; r++)
+      {
+        clock_type::time_point start = clock_type::now();
+        ranking = rank_words(wn, similarity, "dog", vocabulary, 100, nb_threads);
+        times.push_back(elapsed_ms(start));
+      }
+      if (reference.empty())
+        reference = ranking;
+      for (std::size_t i = 0; i < ranking.size(); i++)
+        if (ranking[i].word != reference[i].word)
+          std::cerr << "ranking depends on the number of threads" << std::endl;
+      std::cout << vocabulary.size() << " words, " << nb_threads << " threads, best "
+                << ranking.front().word << " " << ranking.front().score << std::endl;
+      report("rank_words", times);
+    }
+  }
+
+  /// Time all-pairs similarities of words of the vocabulary: a
+  /// max_similarities of each word against all the others vs the tiled
+  /// similarity_matrix
+  void bench_matrix(const std::string& dir, int runs, std::size_t nb_words)
+  {
+    wordnet wn(dir);
+    nltk_similarity similarity(wn);
+
+    std::vector<std::string> vocabulary;
+    for (std::size_t i = 0; i < wn.index_list.size(); i++)
+      if (i == 0 || wn.index_list[i].lemma != wn.index_list[i - 1].lemma)
+        vocabulary.push_back(wn.index_list[i].lemma.to_string());
+    std::shuffle(vocabulary.begin(), vocabulary.end(), std::mt19937(42));
+    vocabulary.resize(std::min(nb_words, vocabulary.size()));
+    std::size_t n = vocabulary.size();
+
+    std::vector<double> times_rows, times_tiles;
+    std::vector<float> rows(n * n), tiles(n * n);
+    for (int r = 0; r < runs; r++)
+    {
+      clock_type::time_point start = clock_type::now();
+      std::vector<int> ids, first, queries;
+      std::vector<float> best;
+      for (std::size_t i = 0; i < n; i++)
+      {
+        first.push_back(ids.size());
+        wn.get_synset_ids(vocabulary[i], ids);
+      }
+      first.push_back(ids.size());
+      for (std::size_t i = 0; i < n; i++)
+      {
+        queries.assign(ids.begin() + first[i], ids.begin() + first[i + 1]);
+        similarity.max_similarities(queries, ids, best);
+        for (std::size_t j = 0; j < n; j++)
+        {
+          float max = 0;
+          for (int k = first[j]; k < first[j + 1]; k++)
+            max = std::max(max, best[k]);
+          rows[i * n + j] = max;
+        }
+      }
+      times_rows.push_back(elapsed_ms(start));
+
+      start = clock_type::now();
+      similarity_matrix(wn, similarity, vocabulary, tiles.data());
+      times_tiles.push_back(elapsed_ms(start));
+    }
+    if (rows != tiles)
+      std::cerr << "matrix mismatch" << std::endl;
+    std::cout << n << " x " << n << " words" << std::endl;
+    report("rows", times_rows);
+    report("similarity_matrix", times_tiles);
+  }
+
+  /// Resident set size of the process in kB (Linux only, 0 elsewhere)
+  long rss_kb()
+  {
+    std::ifstream fin("/proc/self/status");
+    std::string key;
+    while (fin >> key)
+    {
+      if (key == "VmRSS:")
+      {
+        long kb = 0;
+        fin >> kb;
+        return kb;
+      }
+      fin.ignore(4096, '\n');
+    }
+    return 0;
+  }
+
+  /// Memory held by a wordnet loaded from the text database
+  void bench_memory(const std::string& dir, const load_options& options)
+  {
+    long before = rss_kb();
+    wordnet wn(dir, options);
+    long after = rss_kb();
+    std::cout << "rss: " << (after - before) / 1024. << " MB ("
+              << wn.storage.chars.size() / 1024 << " kB of strings)" << std::endl;
+  }
+
+  bool usage(int argc, char ** argv)
+  {
+    std::string dir;
+    if (argc >= 2)
+      dir = std::string(argv[1]);
+    if (argc < 3 || dir[dir.length()-1] != '/')
+    {
+      std::cout << argv[0] << " .../wordnet_dir/ load [runs] [threads]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ snapshot file [runs]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ memory [intern] [lazy]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ lookup [runs]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ synsets [runs]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ morph [runs]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ similarity [runs]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ rank [runs] [max_threads]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ measures [runs]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ cache [runs]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ bfs [runs]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ matrix [runs] [words]" << std::endl;
+      return true;
+    }
+    return false;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  if (usage(argc, argv))
+    return 1;
+
+  std::string wordnet_dir = argv[1];
+  std::string cmd         = argv[2];
+
+  if (cmd == "load")
+    bench_load(wordnet_dir, (argc > 3) ? std::atoi(argv[3]) : 5,
+               (argc > 4) ? std::atoi(argv[4]) : 1);
+  else if (cmd == "lookup")
+    bench_lookup(wordnet_dir, (argc > 3) ? std::atoi(argv[3]) : 5);
+  else if (cmd == "synsets")
+    bench_synsets(wordnet_dir, (argc > 3) ? std::atoi(argv[3]) : 5);
+  else if (cmd == "morph")
+    bench_morph(wordnet_dir, (argc > 3) ? std::atoi(argv[3]) : 5);
+  else if (cmd == "similarity")
+    bench_similarity(wordnet_dir, (argc > 3) ? std::atoi(argv[3]) : 5);
+  else if (cmd == "measures")
+    bench_measures(wordnet_dir, (argc > 3) ? std::atoi(argv[3]) : 5);
+  else if (cmd == "cache")
+    bench_cache(wordnet_dir, (argc > 3) ? std::atoi(argv[3]) : 5);
+  else if (cmd == "bfs")
+    bench_bfs(wordnet_dir, (argc > 3) ? std::atoi(argv[3]) : 5);
+  else if (cmd == "matrix")
+    bench_matrix(wordnet_dir, (argc > 3) ? std::atoi(argv[3]) : 5,
+                 (argc > 4) ? std::atoi(argv[4]) : 5000);
+  else if (cmd == "rank")
+    bench_rank(wordnet_dir, (argc > 3) ? std::atoi(argv[3]) : 5,
+               (argc > 4) ? std::atoi(argv[4])
+               : std::max(1u, std::thread::hardware_concurrency()));
+  else if (cmd == "memory")
+  {
+    load_options options;
+    for (int i = 3; i < argc; i++)
+    {
+      options.intern_strings |= (std::string(argv[i]) == "intern");
+      options.lazy_glosses   |= (std::string(argv[i]) == "lazy");
+    }
+    bench_memory(wordnet_dir, options);
+  }
+  else if (cmd == "snapshot" && argc > 3)
+    bench_snapshot(wordnet_dir, argv[3], (argc > 4) ? std::atoi(argv[4]) : 5);
+  else
+  {
+    std::cerr << "unknown benchmark: " << cmd << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,53 @@
+#!/bin/bash
+
+# Regression checks: outputs of wncheck (and wntest) on the check
+# dictionary (./check/dict/) against the ones stored in ./check/expected/
+# usage: ./check/regress.sh [bin_dir]
+
+BIN=${1:-./bin}
+CHECK=$(dirname "$0")
+WNHOME=$CHECK/dict/
+OUT=$(mktemp -d) || exit 1
+trap 'rm -rf "$OUT"' EXIT
+failed=0
+
+regress() {
+    local expected="$1" program="$2"
+    shift 2
+    echo "$program $WNHOME $* | diff $CHECK/expected/$expected -"
+    if ! "$BIN/$program" $WNHOME "$@" > "$OUT/$expected" 2> "$OUT/$expected.err"; then
+        cat "$OUT/$expected.err"
+        echo "FAILED: $program exited with an error"
+        failed=1
+    elif ! diff -u "$CHECK/expected/$expected" "$OUT/$expected"; then
+        echo "FAILED: output differs from $CHECK/expected/$expected"
+        failed=1
+    fi
+}
+
+# path similarity of every pair of words
+regress similarity_list.txt.sim wncheck similarity $CHECK/similarity_list.txt
+# Wu-Palmer, Leacock-Chodorow and information content similarities (as NLTK)
+regress measures_list.txt.measures wncheck measures $CHECK/measures_list.txt $CHECK/ic-check.dat
+# similarity cache counters
+regress cache.stats wncheck cache
+# distances: breadth_first_search, distance_search one way and bidirectional
+regress similarity_list.txt.distance wncheck distance $CHECK/similarity_list.txt 3
+# most similar synsets, against every synset ranked by similarity
+regress similarity_list.txt.top wncheck most_similar $CHECK/similarity_list.txt 5
+# similarity matrix file and rank_words, on one and several threads
+regress similarity_list.txt.matrix wncheck matrix $CHECK/similarity_list.txt "$OUT/check.matrix" 1
+regress similarity_list.txt.matrix wncheck matrix $CHECK/similarity_list.txt "$OUT/check.matrix" 4
+# base forms (morphword) and synsets (get_synsets) in each pos
+regress morph_list.txt.morph wncheck morph $CHECK/morph_list.txt
+# same through a morphword cache smaller than the list
+regress morph_list.txt.morph wncheck morph $CHECK/morph_list.txt 64
+# same with rules that cannot be compiled (applied one by one)
+regress morph_list.txt.morph wncheck morph_rules $CHECK/morph_list.txt
+# same from a snapshot, which must reload exactly the loaded database
+regress morph_list.txt.morph wncheck snapshot $CHECK/morph_list.txt "$OUT/check.snap"
+# lemmatize, on one and several threads
+regress lemmatize.txt.lemma wntest $CHECK/lemmatize.txt lemmatize 1
+regress lemmatize.txt.lemma wntest $CHECK/lemmatize.txt lemmatize 4
+
+exit $failed
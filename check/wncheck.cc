@@ -0,0 +1,439 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+
+#include <boost/algorithm/string.hpp>
+
+#include <wnb/core/wordnet.hh>
+#include <wnb/nltk_similarity.hh>
+#include <wnb/similarity_measures.hh>
+#include <wnb/similarity_cache.hh>
+#include <wnb/bfs.hh>
+#include <wnb/std_ext.hh>
+
+using namespace wnb;
+
+// Regression checks: the outputs are compared with check/expected/ by
+// check/regress.sh. Lines starting with "MISMATCH" report two computations
+// of the same thing that disagree.
+
+namespace
+{
+  std::vector<std::string> read_list(const std::string& fn)
+  {
+    std::string list = ext::read_file(fn);
+    return ext::split(list);
+  }
+
+  /// Best path similarity of the synsets of every pair of words
+  void check_similarity(const std::string& dir, const std::string& list)
+  {
+    wordnet wn(dir);
+    nltk_similarity similarity(wn);
+    std::vector<std::string> wl = read_list(list);
+
+    std::vector<std::vector<synset> > synsets;
+    for (std::size_t i = 0; i < wl.size(); i++)
+      synsets.push_back(wn.get_synsets(wl[i]));
+
+    for (std::size_t i = 0; i < wl.size(); i++)
+      for (std::size_t j = i + 1; j < wl.size(); j++)
+      {
+        float max = 0;
+        for (std::size_t a = 0; a < synsets[i].size(); a++)
+          for (std::size_t b = 0; b < synsets[j].size(); b++)
+            max = std::max(max, similarity(synsets[i][a], synsets[j][b]));
+        std::cout << wl[i] << " " << wl[j] << " " << max << std::endl;
+      }
+  }
+
+  /// Wu-Palmer, Leacock-Chodorow, Resnik, Lin and Jiang-Conrath
+  /// similarities (information content of ic_file) of the first noun and
+  /// verb synsets of every pair of words
+  void check_measures(const std::string& dir, const std::string& list,
+                      const std::string& ic_file)
+  {
+    wordnet wn(dir);
+    similarity_measures measures(wn);
+    measures.load_ic(ic_file);
+    std::vector<std::string> wl = read_list(list);
+
+    const pos_t pos[] = { N, V };
+    for (std::size_t i = 0; i < wl.size(); i++)
+      for (std::size_t j = i + 1; j < wl.size(); j++)
+        for (std::size_t p = 0; p < 2; p++)
+        {
+          std::vector<synset> s1 = wn.get_synsets(wl[i], pos[p]);
+          std::vector<synset> s2 = wn.get_synsets(wl[j], pos[p]);
+          if (s1.empty() || s2.empty())
+            continue;
+          std::cout << wl[i] << " " << wl[j] << " " << POS_ARRAY[pos[p]]
+                    << " " << measures.wup(s1[0], s2[0])
+                    << " " << measures.lch(s1[0], s2[0])
+                    << " " << measures.resnik(s1[0], s2[0])
+                    << " " << measures.lin(s1[0], s2[0])
+                    << " " << measures.jcn(s1[0], s2[0]) << std::endl;
+        }
+  }
+
+  /// Counters of a similarity_cache of a single set (8 pairs)
+  void check_cache(const std::string& dir)
+  {
+    wordnet wn(dir);
+    nltk_similarity similarity(wn);
+    const wordnet::graph& g = wn.wordnet_graph;
+    similarity_cache<float> cache(8, 1);
+    std::cout << "capacity " << cache.capacity() << std::endl;
+
+    // 20 pairs: 20 misses, 12 evictions, the last 8 pairs are kept
+    for (unsigned i = 0; i < 20; i++)
+      cache(g[i], g[i + 1], similarity);
+    similarity_cache<float>::statistics st = cache.stats();
+    std::cout << "hits " << st.hits << " misses " << st.misses
+              << " evictions " << st.evictions << std::endl;
+
+    for (unsigned i = 12; i < 20; i++)
+      if (cache(g[i], g[i + 1], similarity) != similarity(g[i], g[i + 1]))
+        std::cout << "MISMATCH cached similarity of " << i << " " << i + 1 << std::endl;
+    st = cache.stats();
+    std::cout << "hits " << st.hits << " misses " << st.misses
+              << " evictions " << st.evictions << std::endl;
+
+    // dropped pairs are missed again, counters are kept
+    cache.clear();
+    cache(g[12], g[13], similarity);
+    st = cache.stats();
+    std::cout << "hits " << st.hits << " misses " << st.misses
+              << " evictions " << st.evictions << std::endl;
+  }
+
+  /// Distance over hypernyms and hyponyms of the first synsets of every
+  /// pair of words: breadth_first_search with a distance_recorder (as
+  /// before distance_search), distance_search one way and bidirectional,
+  /// then both bounded to max_depth
+  void check_distance(const std::string& dir, const std::string& list,
+                      int max_depth)
+  {
+    typedef wordnet::graph graph;
+    typedef boost::filtered_graph<graph, bfs::hypo_hyper_edge<graph> > hypo_hyper;
+
+    wordnet wn(dir);
+    const graph& g = wn.wordnet_graph;
+    hypo_hyper fg(g, bfs::hypo_hyper_edge<graph>(g));
+    bfs::distance_search<graph> search(g, bfs::hypo_hyper_edge<graph>(g));
+    std::vector<std::string> wl = read_list(list);
+
+    for (std::size_t i = 0; i < wl.size(); i++)
+      for (std::size_t j = i + 1; j < wl.size(); j++)
+      {
+        std::vector<synset> s1 = wn.get_synsets(wl[i]);
+        std::vector<synset> s2 = wn.get_synsets(wl[j]);
+        if (s1.empty() || s2.empty())
+          continue;
+
+        int d = (s1[0].id == s2[0].id) ? 0 : -1;
+        std::vector<int> dist(num_vertices(g), 0);
+        try
+        {
+          boost::breadth_first_search(fg, s1[0].id,
+            boost::visitor(bfs::record_distance(
+              boost::make_iterator_property_map(dist.begin(),
+                                                get(boost::vertex_index, fg)),
+              s2[0], num_vertices(g))));
+        }
+        catch (int found)
+        {
+          d = found;
+        }
+
+        std::cout << wl[i] << " " << wl[j] << " " << d
+                  << " " << search.distance(s1[0].id, s2[0].id)
+                  << " " << search.bidirectional_distance(s1[0].id, s2[0].id)
+                  << " " << search.distance(s1[0].id, s2[0].id, max_depth)
+                  << " " << search.bidirectional_distance(s1[0].id, s2[0].id, max_depth)
+                  << std::endl;
+      }
+  }
+
+  /// The k synsets most similar to the first synset of every word (of its
+  /// pos), against every synset ranked with operator()
+  void check_most_similar(const std::string& dir, const std::string& list,
+                          std::size_t k)
+  {
+    wordnet wn(dir);
+    nltk_similarity similarity(wn);
+    const wordnet::graph& g = wn.wordnet_graph;
+    std::vector<std::string> wl = read_list(list);
+
+    std::vector<nltk_similarity::synset_score> best;
+    for (std::size_t i = 0; i < wl.size(); i++)
+    {
+      std::vector<synset> synsets = wn.get_synsets(wl[i]);
+      if (synsets.empty())
+        continue;
+      const synset& s = synsets[0];
+      similarity.most_similar(s, k, best, s.pos);
+
+      std::vector<nltk_similarity::synset_score> all;
+      for (unsigned u = 0; u < num_vertices(g); u++)
+      {
+        float score = similarity(s, g[u]);
+        if ((int) u != s.id && g[u].pos == s.pos && score > 0)
+        {
+          nltk_similarity::synset_score ss = { (int) u, score };
+          all.push_back(ss);
+        }
+      }
+      std::sort(all.begin(), all.end(),
+                [](const nltk_similarity::synset_score& x,
+                   const nltk_similarity::synset_score& y)
+                {
+                  return x.score > y.score || (x.score == y.score && x.id < y.id);
+                });
+      all.resize(std::min(k, all.size()));
+
+      for (std::size_t r = 0; r < best.size(); r++)
+        std::cout << wl[i] << " " << best[r].id << " " << g[best[r].id].words[0]
+                  << " " << best[r].score << std::endl;
+      for (std::size_t r = 0; r < std::max(best.size(), all.size()); r++)
+        if (r >= best.size() || r >= all.size()
+            || best[r].id != all[r].id || best[r].score != all[r].score)
+        {
+          std::cout << "MISMATCH most_similar " << wl[i] << " rank " << r << std::endl;
+          break;
+        }
+    }
+  }
+
+  /// Similarity matrix file of a word list (nb_threads threads): header
+  /// and every value, then the 5 best words of each word (rank_words)
+  /// checked against the matrix
+  void check_matrix(const std::string& dir, const std::string& list,
+                    const std::string& fn, unsigned nb_threads)
+  {
+    wordnet wn(dir);
+    nltk_similarity similarity(wn);
+    std::vector<std::string> wl = read_list(list);
+    save_similarity_matrix(wn, similarity, wl, fn, nb_threads);
+
+    std::string file = ext::read_file(fn);
+    similarity_matrix_header h;
+    std::memcpy(&h, file.data(), sizeof(h));
+    std::size_t n = h.nb_words;
+    std::cout << h.magic << " " << std::hex << h.endian_mark << std::dec
+              << " " << n << std::endl;
+    if (file.size() != sizeof(h) + n * n * sizeof(float) || n != wl.size())
+    {
+      std::cout << "MISMATCH matrix size " << file.size() << std::endl;
+      return;
+    }
+    std::vector<float> matrix(n * n);
+    std::memcpy(matrix.data(), file.data() + sizeof(h), n * n * sizeof(float));
+
+    for (std::size_t i = 0; i < n; i++)
+      for (std::size_t j = 0; j < n; j++)
+        std::cout << wl[i] << " " << wl[j] << " " << matrix[i * n + j] << std::endl;
+
+    for (std::size_t i = 0; i < n; i++)
+    {
+      std::vector<word_score> ranking =
+        rank_words(wn, similarity, wl[i], wl, 5, nb_threads);
+      std::cout << "rank " << wl[i] << ":";
+      for (std::size_t r = 0; r < ranking.size(); r++)
+      {
+        std::cout << " " << ranking[r].word << " " << ranking[r].score;
+        std::size_t j = std::find(wl.begin(), wl.end(), ranking[r].word) - wl.begin();
+        if (ranking[r].score != matrix[i * n + j])
+          std::cout << " MISMATCH";
+      }
+      std::cout << std::endl;
+    }
+  }
+
+  /// Base form (morphword) and synsets (get_synsets) of every word in
+  /// every pos
+  void morph(wordnet& wn, const std::vector<std::string>& wl, std::ostream& out)
+  {
+    for (std::size_t i = 0; i < wl.size(); i++)
+      for (unsigned p = 0; p < POS_ARRAY_SIZE; p++) // UNKNOWN first: any pos
+      {
+        pos_t pos = (pos_t) p;
+        out << wl[i] << " " << POS_ARRAY[p] << " -> " << wn.morphword(wl[i], pos) << "\n";
+
+        std::vector<synset> synsets = wn.get_synsets(wl[i], pos);
+        for (std::size_t k = 0; k < synsets.size(); k++)
+        {
+          const synset& s = synsets[k];
+          std::string gloss = wn.gloss(s).to_string();
+          boost::algorithm::trim(gloss);
+          out << "  " << s.id << " " << POS_ARRAY[s.pos] << " ";
+          for (std::size_t w = 0; w < s.words.size(); w++)
+            out << (w ? ", " : "") << s.words[w];
+          out << " -- (" << gloss << ")\n";
+        }
+      }
+  }
+
+  /// Same through a morphword cache of cache_capacity forms (0: none),
+  /// filled by a first pass
+  void check_morph(const std::string& dir, const std::string& list,
+                   std::size_t cache_capacity)
+  {
+    wordnet wn(dir);
+    std::vector<std::string> wl = read_list(list);
+    if (cache_capacity)
+    {
+      wn.set_morph_cache(cache_capacity);
+      std::ostringstream warm;
+      morph(wn, wl, warm);
+    }
+    morph(wn, wl, std::cout);
+  }
+
+  /// Same with rules that cannot be compiled (over morph_trie::max_rules
+  /// nouns and verbs, a lengthening adjective rule), which match no word
+  /// of the list and must not change anything
+  void check_morph_rules(const std::string& dir, const std::string& list)
+  {
+    wordnet wn(dir);
+    for (std::size_t k = 0; k < morph_trie::max_rules; k++)
+    {
+      std::string suffix = "zzz" + std::to_string(k);
+      wn.morphologicalrules[N].push_back(std::make_pair(suffix, ""));
+      wn.morphologicalrules[V].push_back(std::make_pair(suffix, "e"));
+    }
+    wn.morphologicalrules[A].push_back(std::make_pair("zzq", "zzqzz"));
+    wn.compile_morphology();
+    morph(wn, read_list(list), std::cout);
+  }
+
+  /// Print everything loaded in wn: synsets with their pointers, indexes
+  /// and exceptions
+  void dump(const wordnet& wn, std::ostream& out)
+  {
+    const wordnet::graph& g = wn.wordnet_graph;
+    for (unsigned u = 0; u < num_vertices(g); u++)
+    {
+      const synset& s = g[u];
+      out << "synset " << s.id << " " << POS_ARRAY[s.pos] << " " << s.lex_filenum
+          << " " << s.sense_number << " " << s.w_cnt << " " << s.p_cnt;
+      for (std::size_t k = 0; k < s.words.size(); k++)
+        out << " " << s.words[k] << ":" << s.lex_ids[k];
+      for (std::size_t k = 0; k < s.tag_cnts.size(); k++)
+        out << " " << s.tag_cnts[k].first << "=" << s.tag_cnts[k].second;
+      out << " | " << wn.gloss(s) << "\n";
+
+      wordnet::graph::out_edge_iterator e, e_end;
+      for (boost::tie(e, e_end) = out_edges(u, g); e != e_end; ++e)
+        out << "  ptr " << g[*e].pointer_symbol << " " << target(*e, g) << " "
+            << g[*e].source << " " << g[*e].target << "\n";
+    }
+
+    for (std::size_t i = 0; i < wn.index_list.size(); i++)
+    {
+      const wnb::index& idx = wn.index_list[i];
+      out << "index " << idx.lemma << " " << POS_ARRAY[idx.pos] << " " << idx.synset_cnt
+          << " " << idx.p_cnt << " " << idx.sense_cnt << " " << idx.tagsense_cnt;
+      for (std::size_t k = 0; k < idx.ptr_symbols.size(); k++)
+        out << " " << idx.ptr_symbols[k];
+      for (std::size_t k = 0; k < idx.synset_ids.size(); k++)
+        out << " " << idx.synset_offsets[k] << ":" << idx.synset_ids[k];
+      out << "\n";
+    }
+
+    for (std::size_t i = 0; i < wn.exc.size(); i++)
+    {
+      out << "exception " << POS_ARRAY[wn.exc.pos(i)] << " " << wn.exc.form(i);
+      wnb::list_ref<wnb::string_ref> bases = wn.exc.base_forms(i);
+      for (std::size_t k = 0; k < bases.size(); k++)
+        out << " " << bases[k];
+      out << "\n";
+    }
+  }
+
+  /// Same as check_morph from a snapshot (file) of the database, which
+  /// must reload exactly what was loaded
+  void check_snapshot(const std::string& dir, const std::string& list,
+                      const std::string& fn)
+  {
+    wordnet wn(dir);
+    wn.save_snapshot(fn);
+    wordnet reloaded(from_snapshot, fn);
+
+    std::ostringstream loaded, saved;
+    dump(wn, loaded);
+    dump(reloaded, saved);
+    std::istringstream a(loaded.str()), b(saved.str());
+    std::string la, lb;
+    bool more = true;
+    while (more)
+    {
+      more = bool(std::getline(a, la));
+      if (more != bool(std::getline(b, lb)) || la != lb)
+      {
+        std::cout << "MISMATCH snapshot " << fn << ":\n< " << la << "\n> " << lb << std::endl;
+        return;
+      }
+    }
+    morph(reloaded, read_list(list), std::cout);
+  }
+
+  bool usage(int argc, char ** argv)
+  {
+    std::string dir;
+    if (argc >= 2)
+      dir = std::string(argv[1]);
+    if (argc < 3 || dir[dir.length()-1] != '/')
+    {
+      std::cout << argv[0] << " .../wordnet_dir/ similarity word_list_file" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ measures word_list_file ic_file" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ cache" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ distance word_list_file max_depth" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ most_similar word_list_file k" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ matrix word_list_file file [threads]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ morph word_list_file [cache_capacity]" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ morph_rules word_list_file" << std::endl;
+      std::cout << argv[0] << " .../wordnet_dir/ snapshot word_list_file file" << std::endl;
+      return true;
+    }
+    return false;
+  }
+
+} // end of anonymous namespace
+
+int main(int argc, char ** argv)
+{
+  if (usage(argc, argv))
+    return 1;
+
+  std::string wordnet_dir = argv[1];
+  std::string cmd         = argv[2];
+
+  if (cmd == "similarity" && argc > 3)
+    check_similarity(wordnet_dir, argv[3]);
+  else if (cmd == "measures" && argc > 4)
+    check_measures(wordnet_dir, argv[3], argv[4]);
+  else if (cmd == "cache")
+    check_cache(wordnet_dir);
+  else if (cmd == "distance" && argc > 4)
+    check_distance(wordnet_dir, argv[3], std::atoi(argv[4]));
+  else if (cmd == "most_similar" && argc > 4)
+    check_most_similar(wordnet_dir, argv[3], std::atoi(argv[4]));
+  else if (cmd == "matrix" && argc > 4)
+    check_matrix(wordnet_dir, argv[3], argv[4], (argc > 5) ? std::atoi(argv[5]) : 1);
+  else if (cmd == "morph" && argc > 3)
+    check_morph(wordnet_dir, argv[3], (argc > 4) ? std::atoi(argv[4]) : 0);
+  else if (cmd == "morph_rules" && argc > 3)
+    check_morph_rules(wordnet_dir, argv[3]);
+  else if (cmd == "snapshot" && argc > 4)
+    check_snapshot(wordnet_dir, argv[3], argv[4]);
+  else
+  {
+    std::cerr << "unknown check: " << cmd << std::endl;
+    return 1;
+  }
+}
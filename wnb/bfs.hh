@@ -1,6 +1,8 @@
 #ifndef _BFS_HH
 # define _BFS_HH
 
+# include <vector>
+# include <algorithm>
 # include <boost/graph/breadth_first_search.hpp>
 # include <boost/graph/filtered_graph.hpp>
 
@@ -12,6 +14,7 @@ namespace wnb
   {
     /// bfs_visitor
     /// Sum distances and throw answer if target synset found
+    /// (see distance_search for repeated queries)
     template <typename DistanceMap>
     class distance_recorder : public boost::default_bfs_visitor
     {
@@ -48,22 +51,234 @@ namespace wnb
 
     /// This predicate function object determines which edges of the original
     /// graph will show up in the filtered graph.
-    //FIXME: Do we really need a map here (check cost of property_map construction 
-    // / should be light)
-    template <typename PointerSymbolMap>
+    /// Reads the edge bundles of the graph (filtered_graph needs a default
+    /// constructible predicate).
+    template <typename Graph>
     struct hypo_hyper_edge {
-      hypo_hyper_edge() { }
-      hypo_hyper_edge(PointerSymbolMap pointer_symbol)
-        : m_pointer_symbol(pointer_symbol) { }
+      hypo_hyper_edge() : m_graph(0) { }
+      hypo_hyper_edge(const Graph& g)
+        : m_graph(&g) { }
       template <typename Edge>
       bool operator()(const Edge& e) const {
-        int p_s = get(m_pointer_symbol, e);
+        int p_s = (*m_graph)[e].pointer_symbol;
         //see pointer symbol list in info_helper.hh
         return p_s == 1 || p_s == 2 || p_s == 3 || p_s == 4; 
       }
-      PointerSymbolMap m_pointer_symbol;
+      const Graph* m_graph;
     };
 
+    /// Same for any set of relations: bit p of mask accepts pointer
+    /// symbol p (see info_helper.hh)
+    template <typename Graph>
+    struct relation_edge {
+      relation_edge() : m_graph(0), mask(0) { }
+      relation_edge(const Graph& g, unsigned long m)
+        : m_graph(&g), mask(m) { }
+      template <typename Edge>
+      bool operator()(const Edge& e) const {
+        return (mask >> (*m_graph)[e].pointer_symbol) & 1;
+      }
+      const Graph*  m_graph;
+      unsigned long mask;
+    };
+
+
+    /// Shortest distances between synsets over the edges accepted by a
+    /// predicate (hypo_hyper_edge, relation_edge...), without exceptions.
+    ///
+    /// The accepted edges are copied once, forward and backward, to flat
+    /// arrays. Visited synsets are stamped with the number of the query:
+    /// nothing sized to the graph is allocated or cleared per query, and a
+    /// search stops as soon as the target or the depth bound is reached.
+    /// One engine per thread.
+    template <typename Graph>
+    class distance_search
+    {
+    public:
+
+      typedef typename boost::graph_traits<Graph>::vertex_descriptor vertex;
+
+      template <typename EdgePredicate>
+      distance_search(const Graph& g, EdgePredicate accept);
+
+      /// Length of the shortest path from source to target, -1 if there is
+      /// none of at most max_depth edges (no bound if negative)
+      int distance(vertex source, vertex target, int max_depth = -1);
+
+      /// Same, growing the smaller of the frontiers of source and target
+      /// (visits far fewer synsets on long paths)
+      int bidirectional_distance(vertex source, vertex target,
+                                 int max_depth = -1);
+
+    private:
+
+      /// Search from one end
+      struct side
+      {
+        std::vector<std::size_t> first;   ///< edges of u: targets[first[u], first[u + 1])
+        std::vector<vertex>      targets;
+        std::vector<unsigned>    stamp;   ///< last query that reached u
+        std::vector<int>         dist;
+        std::vector<vertex>      frontier, next;
+        int                      depth;   ///< distance of the frontier
+      };
+
+      /// New stamp, frontiers of source and target
+      void new_query(vertex source, vertex target);
+      void start(side& a, vertex s);
+
+      /// Visit the next level of a, returns the length of a path through
+      /// a synset also reached by b (the shortest one), -1 if none
+      int expand(side& a, const side& b);
+
+      static bool within(int depth, int max_depth)
+      {
+        return max_depth < 0 || depth < max_depth;
+      }
+
+      side     forward, backward;
+      unsigned epoch;
+    };
+
+
+    template <typename Graph>
+    template <typename EdgePredicate>
+    distance_search<Graph>::distance_search(const Graph& g, EdgePredicate accept)
+      : epoch(0)
+    {
+      std::size_t n = num_vertices(g);
+      forward.first.assign(n + 1, 0);
+      backward.first.assign(n + 1, 0);
+
+      typename boost::graph_traits<Graph>::edge_iterator e, e_end;
+      for (boost::tie(e, e_end) = edges(g); e != e_end; ++e)
+        if (accept(*e))
+        {
+          forward.first[source(*e, g) + 1]++;
+          backward.first[target(*e, g) + 1]++;
+        }
+      for (std::size_t i = 0; i < n; i++)
+      {
+        forward.first[i + 1]  += forward.first[i];
+        backward.first[i + 1] += backward.first[i];
+      }
+
+      forward.targets.resize(forward.first[n]);
+      backward.targets.resize(backward.first[n]);
+      std::vector<std::size_t> f(forward.first.begin(), forward.first.end() - 1);
+      std::vector<std::size_t> b(backward.first.begin(), backward.first.end() - 1);
+      for (boost::tie(e, e_end) = edges(g); e != e_end; ++e)
+        if (accept(*e))
+        {
+          vertex u = source(*e, g), v = target(*e, g);
+          forward.targets[f[u]++]  = v;
+          backward.targets[b[v]++] = u;
+        }
+
+      forward.stamp.assign(n, 0);
+      backward.stamp.assign(n, 0);
+      forward.dist.assign(n, 0);
+      backward.dist.assign(n, 0);
+    }
+
+
+    template <typename Graph>
+    void
+    distance_search<Graph>::new_query(vertex source, vertex target)
+    {
+      if (++epoch == 0) // wrapped around: forget every stamp
+      {
+        std::fill(forward.stamp.begin(), forward.stamp.end(), 0);
+        std::fill(backward.stamp.begin(), backward.stamp.end(), 0);
+        epoch = 1;
+      }
+      start(forward, source);
+      start(backward, target);
+    }
+
+
+    template <typename Graph>
+    void
+    distance_search<Graph>::start(side& a, vertex s)
+    {
+      a.stamp[s] = epoch;
+      a.dist[s]  = 0;
+      a.depth    = 0;
+      a.frontier.clear();
+      a.frontier.push_back(s);
+    }
+
+
+    template <typename Graph>
+    int
+    distance_search<Graph>::expand(side& a, const side& b)
+    {
+      // No path is shorter than a.depth + b.depth + 1 (it would have been
+      // met before), so the first synset reached by both ends gives the
+      // distance.
+      a.next.clear();
+      for (std::size_t i = 0; i < a.frontier.size(); i++)
+      {
+        vertex u = a.frontier[i];
+        for (std::size_t k = a.first[u]; k < a.first[u + 1]; k++)
+        {
+          vertex v = a.targets[k];
+          if (a.stamp[v] == epoch)
+            continue;
+          if (b.stamp[v] == epoch)
+            return a.depth + 1 + b.dist[v];
+          a.stamp[v] = epoch;
+          a.dist[v]  = a.depth + 1;
+          a.next.push_back(v);
+        }
+      }
+      a.frontier.swap(a.next);
+      a.depth++;
+      return -1;
+    }
+
+
+    template <typename Graph>
+    int
+    distance_search<Graph>::distance(vertex source, vertex target, int max_depth)
+    {
+      if (source == target)
+        return 0;
+
+      new_query(source, target);
+
+      while (!forward.frontier.empty() && within(forward.depth, max_depth))
+      {
+        int d = expand(forward, backward);
+        if (d >= 0)
+          return d;
+      }
+      return -1;
+    }
+
+
+    template <typename Graph>
+    int
+    distance_search<Graph>::bidirectional_distance(vertex source, vertex target,
+                                                   int max_depth)
+    {
+      if (source == target)
+        return 0;
+
+      new_query(source, target);
+
+      while (!forward.frontier.empty() && !backward.frontier.empty()
+             && within(forward.depth + backward.depth, max_depth))
+      {
+        int d = (forward.frontier.size() <= backward.frontier.size())
+          ? expand(forward, backward)
+          : expand(backward, forward);
+        if (d >= 0)
+          return d;
+      }
+      return -1;
+    }
+
   } // end of wnb::bfs
 
 } // end of namespace wnb
@@ -0,0 +1,259 @@
+#ifndef _ARENA_HH
+# define _ARENA_HH
+
+# include <string>
+# include <vector>
+# include <utility>
+# include <cstddef>
+# include <stdexcept>
+# include <iterator>
+# include <functional>
+
+# include <boost/utility/string_ref.hpp>
+
+namespace wnb
+{
+
+  /// Non-owning reference to characters (of the arena of a wordnet)
+  /// Converts to std::string (a copy), the former type of the strings of
+  /// synsets and indexes, so that code written for them still compiles.
+  class string_ref : public boost::string_ref
+  {
+  public:
+    string_ref() { }
+    string_ref(const char* s) : boost::string_ref(s) { }
+    string_ref(const char* s, std::size_t n) : boost::string_ref(s, n) { }
+    string_ref(const char* b, const char* e) : boost::string_ref(b, e - b) { }
+    /// Explicit: a view of a temporary std::string would dangle
+    explicit string_ref(const std::string& s) : boost::string_ref(s) { }
+    string_ref(boost::string_ref s) : boost::string_ref(s) { }
+
+    operator std::string() const { return to_string(); }
+
+    string_ref substr(size_type pos, size_type n = npos) const
+    {
+      return boost::string_ref::substr(pos, n);
+    }
+  };
+
+  inline std::string operator+(const std::string& a, string_ref b) { return a + b.to_string(); }
+  inline std::string operator+(string_ref a, const std::string& b) { return a.to_string() + b; }
+  inline std::string operator+(const char* a, string_ref b) { return a + b.to_string(); }
+  inline std::string operator+(string_ref a, const char* b) { return a.to_string() + b; }
+  inline std::string operator+(string_ref a, string_ref b) { return a.to_string() + b.to_string(); }
+
+  /// Non-owning reference to a contiguous list (e.g. the words of a synset)
+  /// Read like a const std::vector.
+  template <typename T>
+  struct list_ref
+  {
+    typedef T                  value_type;
+    typedef const T*           const_iterator;
+    typedef const T*           iterator;
+    typedef const T&           const_reference;
+    typedef const T&           reference;
+    typedef std::size_t        size_type;
+
+    list_ref() : b(0), e(0) { }
+    list_ref(const T* begin, const T* end) : b(begin), e(end) { }
+
+    const T*    begin() const { return b; }
+    const T*    end()   const { return e; }
+    std::size_t size()  const { return e - b; }
+    bool        empty() const { return b == e; }
+
+    const T& operator[](std::size_t i) const { return b[i]; }
+    const T& at(std::size_t i) const
+    {
+      if (i >= size())
+        throw std::out_of_range("wnb::list_ref::at");
+      return b[i];
+    }
+    const T& front() const { return *b; }
+    const T& back()  const { return *(e - 1); }
+
+    /// Copy to a vector (the former type of the lists of synsets and
+    /// indexes), e.g. std::vector<std::string> words = synset.words;
+    template <typename U>
+    operator std::vector<U>() const { return std::vector<U>(b, e); }
+
+    const T* b;
+    const T* e;
+  };
+
+
+  /// Hash of a string (FNV-1a)
+  inline std::size_t string_hash(string_ref s)
+  {
+    std::size_t h = 2166136261u;
+    for (std::size_t i = 0; i < s.size(); i++)
+      h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+  }
+
+
+  /// Append-only contiguous storage whose capacity is fixed once reserved,
+  /// so that references to its elements stay valid.
+  template <typename T>
+  class pool
+  {
+  public:
+    pool() { }
+
+    /// Copy with the same capacity (references into other still refer to
+    /// other, see rebase)
+    pool(const pool& other) { *this = other; }
+
+    pool& operator=(const pool& other)
+    {
+      if (this != &other)
+      {
+        std::vector<T> data;
+        data.reserve(other.capacity());
+        data = other._data;
+        _data.swap(data);
+      }
+      return *this;
+    }
+
+    /// Drop the content and make room for exactly n elements
+    void reset(std::size_t n)
+    {
+      std::vector<T>().swap(_data);
+      _data.reserve(n);
+    }
+
+    std::size_t size()     const { return _data.size(); }
+    std::size_t capacity() const { return _data.capacity(); }
+
+    /// Reference to the elements [b, e) of the pool
+    list_ref<T> range(std::size_t b, std::size_t e) const
+    {
+      return list_ref<T>(_data.data() + b, _data.data() + e);
+    }
+
+    void push_back(const T& v)
+    {
+      reserve_more(1);
+      _data.push_back(v);
+    }
+
+    template <typename Iterator>
+    list_ref<T> append(Iterator b, Iterator e)
+    {
+      std::size_t first = _data.size();
+      reserve_more(std::distance(b, e));
+      _data.insert(_data.end(), b, e);
+      return range(first, _data.size());
+    }
+
+    /// Same position in this pool as p in other (of which this pool is a
+    /// copy), p itself if it does not point into other
+    const T* rebase(const T* p, const pool& other) const
+    {
+      const T* b = other._data.data();
+      std::less<const T*> less;
+      if (!b || less(p, b) || less(b + other._data.size(), p))
+        return p;
+      return _data.data() + (p - b);
+    }
+
+    list_ref<T> rebase(list_ref<T> l, const pool& other) const
+    {
+      return list_ref<T>(rebase(l.begin(), other), rebase(l.end(), other));
+    }
+
+    /// Apply f to every element, in place
+    template <typename F>
+    void transform(F f)
+    {
+      for (std::size_t i = 0; i < _data.size(); i++)
+        _data[i] = f(_data[i]);
+    }
+
+  private:
+    void reserve_more(std::size_t n) const
+    {
+      if (_data.capacity() - _data.size() < n)
+        throw std::logic_error("wnb::pool: capacity exceeded");
+    }
+
+    std::vector<T> _data;
+  };
+
+
+  /// Storage of the strings and lists referenced by the synsets and
+  /// indexes of a wordnet: one char pool and one flat array per list type.
+  struct arena
+  {
+    typedef std::pair<string_ref, int> tag_cnt;
+
+    arena() { }
+
+    /// Copy whose strings and lists refer to its own pools
+    arena(const arena& other) { *this = other; }
+
+    arena& operator=(const arena& other)
+    {
+      if (this != &other)
+      {
+        chars   = other.chars;
+        strings = other.strings;
+        ints    = other.ints;
+        tags    = other.tags;
+        strings.transform(rebaser(*this, other));
+        tags.transform(rebaser(*this, other));
+      }
+      return *this;
+    }
+
+    /// Same references into this arena as s, l into other (of which this
+    /// arena is a copy)
+    string_ref rebase(string_ref s, const arena& other) const
+    {
+      return string_ref(chars.rebase(s.data(), other.chars), s.size());
+    }
+    list_ref<string_ref> rebase(list_ref<string_ref> l, const arena& other) const
+    {
+      return strings.rebase(l, other.strings);
+    }
+    list_ref<int> rebase(list_ref<int> l, const arena& other) const
+    {
+      return ints.rebase(l, other.ints);
+    }
+    list_ref<tag_cnt> rebase(list_ref<tag_cnt> l, const arena& other) const
+    {
+      return tags.rebase(l, other.tags);
+    }
+
+    /// Copy s into the char pool
+    string_ref add(string_ref s)
+    {
+      list_ref<char> r = chars.append(s.begin(), s.end());
+      return string_ref(r.begin(), r.size());
+    }
+
+    pool<char>       chars;   ///< words, lemmas, glosses, pointer symbols
+    pool<string_ref> strings; ///< synset words, index pointer symbols
+    pool<int>        ints;    ///< lex ids, index offsets and ids
+    pool<tag_cnt>    tags;    ///< synset tag counts
+
+  private:
+    struct rebaser
+    {
+      rebaser(const arena& to, const arena& from) : to(to), from(from) { }
+
+      string_ref operator()(string_ref s) const { return to.rebase(s, from); }
+      tag_cnt operator()(const tag_cnt& t) const
+      {
+        return tag_cnt(to.rebase(t.first, from), t.second);
+      }
+
+      const arena& to;
+      const arena& from;
+    };
+  };
+
+} // end of namespace wnb
+
+#endif /* _ARENA_HH */
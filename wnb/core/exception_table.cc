@@ -0,0 +1,139 @@
+#include "exception_table.hh"
+
+namespace wnb
+{
+
+  exception_table::exception_table(const exception_table& other)
+  {
+    *this = other;
+  }
+
+  exception_table&
+  exception_table::operator=(const exception_table& other)
+  {
+    if (this != &other)
+    {
+      _chars   = other._chars;
+      _entries = other._entries;
+      _texts   = other._texts;
+      for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+        _slots[p] = other._slots[p];
+      _bases.clear();
+      if (!other._bases.empty())
+        refer_bases();
+    }
+    return *this;
+  }
+
+  exception_table::text
+  exception_table::add_text(string_ref s)
+  {
+    text t = { (uint32_t)_chars.size(), (uint32_t)s.size() };
+    _chars.insert(_chars.end(), s.begin(), s.end());
+    return t;
+  }
+
+  void
+  exception_table::add(pos_t pos, string_ref form, string_ref base)
+  {
+    // consecutive base forms of a form (as in the files) are kept together
+    if (_entries.empty() || _entries.back().pos != pos ||
+        this->form(_entries.size() - 1) != form)
+    {
+      entry e = { pos, add_text(form), (uint32_t)_texts.size(), 0 };
+      _entries.push_back(e);
+    }
+    _texts.push_back(add_text(base));
+    _entries.back().count++;
+  }
+
+  void
+  exception_table::build()
+  {
+    std::size_t n = _entries.size();
+    std::size_t nb_entries[POS_ARRAY_SIZE] = { 0 };
+    for (std::size_t k = 0; k < n; k++)
+      nb_entries[_entries[k].pos]++;
+
+    // load factor <= 1/2
+    slot free_slot = { 0, none };
+    for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+    {
+      std::size_t size = 1;
+      while (size < 2 * nb_entries[p])
+        size <<= 1;
+      std::vector<slot>(nb_entries[p] ? size : 0, free_slot).swap(_slots[p]);
+    }
+
+    // a form added again gets its base forms appended to the first one
+    std::vector<uint32_t> next(n, none), last(n);
+    std::vector<slot*>    slots(n, (slot*)0); ///< of the first entries
+    for (std::size_t k = 0; k < n; k++)
+    {
+      std::vector<slot>& table = _slots[_entries[k].pos];
+      std::size_t mask = table.size() - 1;
+      uint32_t    h = string_hash(form(k));
+      std::size_t i = h & mask;
+      while (table[i].entry != none &&
+             !(table[i].hash == h && form(table[i].entry) == form(k)))
+        i = (i + 1) & mask;
+
+      if (table[i].entry == none)
+      {
+        slot s = { h, (uint32_t)k };
+        table[i] = s;
+        slots[k] = &table[i];
+        last[k] = k;
+      }
+      else
+      {
+        uint32_t first = table[i].entry;
+        next[last[first]] = k;
+        last[first] = k;
+      }
+    }
+
+    // drop the entries merged into others, base forms made contiguous
+    std::vector<entry> entries;
+    std::vector<text>  texts;
+    entries.reserve(n);
+    texts.reserve(_texts.size());
+    for (std::size_t k = 0; k < n; k++)
+    {
+      if (!slots[k])
+        continue;
+      entry e = _entries[k];
+      e.first = texts.size();
+      for (uint32_t j = k; j != none; j = next[j])
+        texts.insert(texts.end(), _texts.begin() + _entries[j].first,
+                     _texts.begin() + _entries[j].first + _entries[j].count);
+      e.count = texts.size() - e.first;
+      slots[k]->entry = entries.size();
+      entries.push_back(e);
+    }
+    _entries.swap(entries);
+    _texts.swap(texts);
+
+    refer_bases();
+  }
+
+  void
+  exception_table::refer_bases()
+  {
+    _bases.resize(_texts.size());
+    for (std::size_t i = 0; i < _texts.size(); i++)
+      _bases[i] = text_ref(_texts[i]);
+  }
+
+  void
+  exception_table::clear()
+  {
+    _chars.clear();
+    _entries.clear();
+    _texts.clear();
+    _bases.clear();
+    for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+      _slots[p].clear();
+  }
+
+} // end of namespace wnb
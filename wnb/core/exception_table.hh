@@ -0,0 +1,108 @@
+#ifndef _EXCEPTION_TABLE_HH
+# define _EXCEPTION_TABLE_HH
+
+# include <vector>
+# include <cstddef>
+
+# include <stdint.h>
+
+# include "arena.hh"
+# include "pos_t.hh"
+
+namespace wnb
+{
+
+  /// Morphological exceptions (*.exc files): inflected form -> base forms,
+  /// per pos. Forms and base forms share one char pool, the base forms of
+  /// a form are contiguous, and each pos has an open addressing table
+  /// built once every exception is added.
+  class exception_table
+  {
+  public:
+    exception_table() { }
+
+    /// Copy (base forms refer to the chars of the copy)
+    exception_table(const exception_table& other);
+    exception_table& operator=(const exception_table& other);
+
+    /// Add base as a base form of form in pos (after the ones already
+    /// added for form). Call build before find.
+    void add(pos_t pos, string_ref form, string_ref base);
+
+    /// Index the exceptions added
+    void build();
+
+    void clear();
+
+    /// Base forms of form in pos, empty if form is not an exception
+    /// (const, no allocation)
+    list_ref<string_ref> find(pos_t pos, string_ref form) const
+    {
+      const std::vector<slot>& slots = _slots[pos];
+      if (slots.empty())
+        return list_ref<string_ref>();
+
+      std::size_t mask = slots.size() - 1;
+      uint32_t h = string_hash(form);
+      for (std::size_t i = h & mask; ; i = (i + 1) & mask)
+      {
+        const slot& s = slots[i];
+        if (s.entry == none)
+          return list_ref<string_ref>();
+        if (s.hash == h && this->form(s.entry) == form)
+          return base_forms(s.entry);
+      }
+    }
+
+    /// Exceptions, in order of addition (once built)
+    std::size_t size()              const { return _entries.size(); }
+    pos_t       pos(std::size_t i)  const { return _entries[i].pos; }
+    string_ref  form(std::size_t i) const { return text_ref(_entries[i].form); }
+
+    list_ref<string_ref> base_forms(std::size_t i) const
+    {
+      const string_ref* b = _bases.data() + _entries[i].first;
+      return list_ref<string_ref>(b, b + _entries[i].count);
+    }
+
+  private:
+    static const uint32_t none = uint32_t(-1);
+
+    /// Characters of _chars
+    struct text
+    {
+      uint32_t offset;
+      uint32_t size;
+    };
+
+    struct entry
+    {
+      pos_t    pos;
+      text     form;
+      uint32_t first; ///< base forms [first, first + count) of _texts/_bases
+      uint32_t count;
+    };
+
+    struct slot
+    {
+      uint32_t hash;
+      uint32_t entry; ///< none if free
+    };
+
+    text       add_text(string_ref s);
+    void       refer_bases(); ///< set _bases from _texts
+    string_ref text_ref(const text& t) const
+    {
+      return string_ref(_chars.data() + t.offset, t.size);
+    }
+
+    std::vector<char>       _chars;
+    std::vector<entry>      _entries;
+    std::vector<text>       _texts; ///< base forms
+    std::vector<string_ref> _bases; ///< same, into _chars (once built)
+    std::vector<slot>       _slots[POS_ARRAY_SIZE];
+  };
+
+} // end of namespace wnb
+
+#endif /* _EXCEPTION_TABLE_HH */
@@ -1,9 +1,8 @@
 #include "info_helper.hh"
+#include "mapped_file.hh"
+#include "scanner.hh"
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <map>
 
 #include <cassert>
 
@@ -77,56 +76,54 @@ namespace wnb
     indice_offset[UNKNOWN] = 0;
 
     indice_offset[N] = 0;
-    indice_offset[V] = indice_offset[N] + pos_maps[N].size();
-    indice_offset[A] = indice_offset[V] + pos_maps[V].size();
-    indice_offset[R] = indice_offset[A] + pos_maps[A].size();
-    indice_offset[S] = indice_offset[R] + pos_maps[R].size();
+    indice_offset[V] = indice_offset[N] + pos_offsets[N].size();
+    indice_offset[A] = indice_offset[V] + pos_offsets[V].size();
+    indice_offset[R] = indice_offset[A] + pos_offsets[A].size();
+    indice_offset[S] = indice_offset[R] + pos_offsets[R].size();
 
   }
 
-  int info_helper::compute_indice(int offset, pos_t pos)
+  void
+  info_helper::set_offsets(pos_t pos, offsets_t offsets)
   {
-    if (pos == S)
-      pos = A;
-    std::map<int,int>& map = pos_maps[pos];
-
     assert(pos <= 5 && pos > 0);
 
-    return indice_offset[pos] + map[offset];
+    for (std::size_t i = 1; i < offsets.size(); i++)
+      if (offsets[i - 1] >= offsets[i])
+        throw std::runtime_error("Synset offsets are not strictly increasing");
+
+    pos_offsets[pos].swap(offsets);
+    update_pos_maps();
   }
 
   // Function definitions
 
-  // Return relation between synset indices and offsets
+  // Return synset offsets, in file order
+  // (only the leading offset of each line is read)
   static
-  std::map<int,int>
+  info_helper::offsets_t
   preprocess_data(const std::string& fn)
   {
-    std::map<int,int> map;
-    std::ifstream file(fn.c_str());
-    if (!file.is_open())
-      throw std::runtime_error("preprocess_data: File not found: " + fn);
-
-    std::string row;
+    info_helper::offsets_t offsets;
+    mapped_file file(fn);
+    scan::lines lines(file.begin(), file.end());
 
     //skip header
     const unsigned int header_nb_lines = 29;
-    for(std::size_t i = 0; i < header_nb_lines; i++)
-      std::getline(file, row);
+    lines.skip(header_nb_lines);
 
-    int ind = 0;
     //parse data line
-    while (std::getline(file, row))
+    const char* b;
+    const char* e;
+    while (lines.next(b, e))
     {
-      std::stringstream srow(row);
-      int offset;
-      srow >> offset;
-      map.insert(std::pair<int,int>(offset, ind));
-      ind++;
+      scan::fields srow(b, e);
+      int offset = 0;
+      srow.dec(offset);
+      offsets.push_back(offset);
     }
 
-    file.close();
-    return map;
+    return offsets;
   }
 
   info_helper
@@ -134,15 +131,12 @@ namespace wnb
   {
     info_helper info;
 
-    info.pos_maps[N] = preprocess_data((dn + "data.noun")); // noun_map
-    info.pos_maps[V] = preprocess_data((dn + "data.verb")); // verb_map
-    info.pos_maps[A] = preprocess_data((dn + "data.adj"));  // adj_map
-    info.pos_maps[R] = preprocess_data((dn + "data.adv"));  // adv_map
-
-    info.update_pos_maps();
+    info.set_offsets(N, preprocess_data((dn + "data.noun")));
+    info.set_offsets(V, preprocess_data((dn + "data.verb")));
+    info.set_offsets(A, preprocess_data((dn + "data.adj")));
+    info.set_offsets(R, preprocess_data((dn + "data.adv")));
 
     return info;
   }
 
 } // end of namespace wnb
-
@@ -3,7 +3,8 @@
 
 # include <string>
 # include <stdexcept>
-# include <map>
+# include <vector>
+# include <cstring>
 
 # include "pos_t.hh"
 
@@ -25,41 +26,71 @@ namespace wnb
     static const int  offsets[NUMPARTS];
     static const int  cnts[NUMPARTS];
 
-    typedef std::map<int,int>       i2of_t;     ///< indice/offset correspondences
-    typedef std::map<pos_t, i2of_t> pos_i2of_t; ///< pos / map  correspondences
+    /// Synset offsets of a pos in increasing order, the rank of an offset
+    /// is the local indice of its synset
+    typedef std::vector<int> offsets_t;
 
     /// Constructor
     info_helper() { update_pos_maps(); }
 
     /// Compute the number of synsets (i.e. the number of vertex in the graph)
-    unsigned nb_synsets()
+    unsigned nb_synsets() const
     {
-      typedef pos_i2of_t::iterator iter_t;
-
-      int sum = 0;
-      for (iter_t it = pos_maps.begin(); it != pos_maps.end(); it++)
-        sum += (*it).second.size();
-
+      std::size_t sum = 0;
+      for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+        sum += pos_offsets[p].size();
       return sum;
-      //return adj_map.size() + adv_map.size() + noun_map.size() + verb_map.size();
     };
 
     // Given a pos return the starting indice in the graph
-    int get_indice_offset(pos_t pos)
+    int get_indice_offset(pos_t pos) const
     {
       return indice_offset[pos];
     };
 
     /// Helper function computing global indice in graph from local offset
-    int compute_indice(int offset, pos_t pos);
+    /// Return -1 if no synset of pos has this offset.
+    int compute_indice(int offset, pos_t pos) const
+    {
+      if (pos == S)
+        pos = A;
+      if (pos <= UNKNOWN || pos >= (int)POS_ARRAY_SIZE)
+        return -1;
+
+      // branchless binary search of the last offset <= offset
+      const offsets_t& v = pos_offsets[pos];
+      if (v.empty())
+        return -1;
+      const int*  base = v.data();
+      std::size_t n    = v.size();
+      while (n > 1)
+      {
+        std::size_t half = n / 2;
+        base = (base[half] <= offset) ? base + half : base;
+        n -= half;
+      }
+      if (*base != offset)
+        return -1;
+      return indice_offset[pos] + (base - v.data());
+    }
+
+    /// Set the synset offsets of pos (must be strictly increasing, as in
+    /// data.* files) and update indice offsets
+    void set_offsets(pos_t pos, offsets_t offsets);
 
-    /// Update a map allowing one to get the correct map given a pos
+    /// Update indice offsets after a change of pos_offsets
     void update_pos_maps();
 
-    int get_symbol(const std::string& ps)
+    static int get_symbol(const std::string& ps)
+    {
+      return get_symbol(ps.data(), ps.size());
+    }
+
+    /// Same as above on a non null-terminated symbol (e.g. in a mapped file)
+    static int get_symbol(const char* ps, std::size_t len)
     {
       for (unsigned i = 0; i < NB_SYMBOLS; i++)
-        if (ps == symbols[i])
+        if (std::strlen(symbols[i]) == len && !std::strncmp(ps, symbols[i], len))
           return i;
       throw std::runtime_error("Symbol NOT FOUND.");
     }
@@ -71,16 +102,12 @@ namespace wnb
 
   public:
 
-    // i2of_t adj_map;
-    // i2of_t adv_map;
-    // i2of_t noun_map;
-    // i2of_t verb_map;
-
-    pos_i2of_t  pos_maps;
+    offsets_t   pos_offsets[POS_ARRAY_SIZE]; ///< S synsets are in A
     std::size_t indice_offset[POS_ARRAY_SIZE];
   };
 
   /// Create a new info_help based on wordnet data located in dn (../dict/)
+  /// (load_wordnet builds its own while parsing, this is a standalone scan)
   info_helper preprocess_wordnet(const std::string& dn);
 
 } // end of namespace wncpp
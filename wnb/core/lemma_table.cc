@@ -0,0 +1,40 @@
+#include "lemma_table.hh"
+#include "wordnet.hh"
+
+namespace wnb
+{
+
+  void
+  lemma_table::build(const std::vector<index>& index_list)
+  {
+    std::size_t nb_lemmas = 0;
+    for (std::size_t k = 0; k < index_list.size(); k++)
+      if (k == 0 || index_list[k].lemma != index_list[k - 1].lemma)
+        nb_lemmas++;
+
+    // load factor <= 1/2
+    std::size_t size = 1;
+    while (size < 2 * nb_lemmas)
+      size <<= 1;
+    slot free_slot = { 0, 0, 0 };
+    std::vector<slot>(size, free_slot).swap(_slots);
+    _mask = size - 1;
+
+    for (std::size_t k = 0; k < index_list.size(); )
+    {
+      std::size_t last = k + 1;
+      while (last < index_list.size() && index_list[last].lemma == index_list[k].lemma)
+        last++;
+
+      uint32_t h = string_hash(index_list[k].lemma);
+      std::size_t i = h & _mask;
+      while (_slots[i].count != 0)
+        i = (i + 1) & _mask;
+      slot s = { h, (uint32_t)k, (uint32_t)(last - k) };
+      _slots[i] = s;
+
+      k = last;
+    }
+  }
+
+} // end of namespace wnb
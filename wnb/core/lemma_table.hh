@@ -0,0 +1,62 @@
+#ifndef _LEMMA_TABLE_HH
+# define _LEMMA_TABLE_HH
+
+# include <vector>
+# include <utility>
+# include <cstddef>
+
+# include <stdint.h>
+
+# include "arena.hh"
+
+namespace wnb
+{
+  /// forward declaration
+  struct index;
+
+  /// Lemma -> entries of a sorted index list (one per pos)
+  /// Open addressing table built once the index list is complete.
+  class lemma_table
+  {
+  public:
+    typedef std::pair<std::size_t, std::size_t> range_t; ///< [first, last)
+
+    lemma_table() : _mask(0) { }
+
+    /// Index the lemmas of index_list (sorted by lemma)
+    void build(const std::vector<index>& index_list);
+
+    /// Positions in index_list of the entries of lemma, empty if unknown
+    /// (index_list must be the list the table was built from)
+    template <typename Index>
+    range_t find(string_ref lemma, const std::vector<Index>& index_list) const
+    {
+      if (_slots.empty())
+        return range_t(0, 0);
+
+      uint32_t h = string_hash(lemma);
+      for (std::size_t i = h & _mask; ; i = (i + 1) & _mask)
+      {
+        const slot& s = _slots[i];
+        if (s.count == 0)
+          return range_t(0, 0);
+        if (s.hash == h && index_list[s.first].lemma == lemma)
+          return range_t(s.first, s.first + s.count);
+      }
+    }
+
+  private:
+    struct slot
+    {
+      uint32_t hash;
+      uint32_t first;
+      uint32_t count; ///< 0 if free
+    };
+
+    std::size_t       _mask;
+    std::vector<slot> _slots;
+  };
+
+} // end of namespace wnb
+
+#endif /* _LEMMA_TABLE_HH */
@@ -14,7 +14,11 @@
 #include <wnb/std_ext.hh>
 
 #include "wordnet.hh"
+#include "arena.hh"
 #include "info_helper.hh"
+#include "mapped_file.hh"
+#include "run_jobs.hh"
+#include "scanner.hh"
 #include "pos_t.hh"
 
 namespace bg = boost::graph;
@@ -25,360 +29,654 @@ namespace wnb
   namespace
   {
 
-    // Load synset's words
-    void load_data_row_words(std::stringstream& srow, synset& synset)
+    /// Relation between two synsets, waiting to be added to the graph.
+    /// Targets are only known by offset until every data file is read.
+    struct rel
     {
-      srow >> std::hex >> synset.w_cnt >> std::dec;
+      int   u;        ///< source synset (position in cat_buffer::synsets)
+      int   v_offset; ///< target synset offset
+      pos_t v_pos;    ///< target synset pos
+      int   v;        ///< target synset indice (once resolved)
+      ptr   p;
+    };
+
+    /// Everything parsed from the files of one category (e.g. "noun").
+    /// Categories are parsed independently (possibly in parallel), then
+    /// offsets are resolved to indices and the buffers are merged into the
+    /// wordnet in a fixed order.
+    ///
+    /// Strings still point into the mapped files and lists are kept flat,
+    /// in file order; merging copies them into the arena of the wordnet.
+    struct cat_buffer
+    {
+      std::string         cat;
+      pos_t               pos;
+      mapped_file         data_file;
+      mapped_file         index_file;
+      std::vector<int>    offsets; ///< synset offsets, in data file order
+      std::vector<synset> synsets; ///< in data file order
+      std::vector<string_ref> words;   ///< w_cnt per synset
+      std::vector<int>        lex_ids; ///< w_cnt per synset
+      std::vector<rel>    rels;    ///< in data file order
+      std::vector<index>  indexes; ///< in index file order
+      std::vector<string_ref>  ptr_symbols;    ///< p_cnt per index
+      std::vector<std::size_t> nb_offsets;     ///< per index
+      std::vector<int>         synset_offsets; ///< nb_offsets per index
+      std::vector<int>         synset_ids;     ///< same, once resolved
+      mapped_file         exc_file;
+      std::vector<std::pair<string_ref, string_ref> > exceptions; ///< form, base form
+    };
+
+    /// One row of index.sense, waiting to be applied to the graph
+    struct sense_rec
+    {
+      int         synset_offset;
+      pos_t       pos;
+      int         u;           ///< synset indice (once resolved)
+      int         sense_number;
+      int         tag_cnt;
+      string_ref  word;        ///< only set when tag_cnt != 0
+    };
+
+    /// Rows of index.sense (words point into file)
+    struct sense_buffer
+    {
+      mapped_file            file;
+      std::vector<sense_rec> recs;
+    };
+
+    /// Copy strings into an arena, sharing the storage of equal strings
+    /// if enabled (open addressing table, sized for at most nb_strings
+    /// distinct strings)
+    class interner
+    {
+    public:
+      interner(arena& a, std::size_t nb_strings, bool enabled)
+        : _arena(a), _mask(0)
+      {
+        if (!enabled)
+          return;
+        _mask = 1;
+        while (_mask < 2 * nb_strings)
+          _mask <<= 1;
+        _refs.resize(_mask);
+        _mask -= 1;
+      }
+
+      string_ref operator()(string_ref s)
+      {
+        if (_refs.empty())
+          return _arena.add(s);
+        for (std::size_t i = string_hash(s) & _mask; ; i = (i + 1) & _mask)
+        {
+          string_ref& r = _refs[i];
+          if (r.data() == 0)
+            return r = _arena.add(s);
+          if (r == s)
+            return r;
+        }
+      }
+
+    private:
+      arena&                  _arena;
+      std::size_t             _mask;
+      std::vector<string_ref> _refs; ///< views into _arena, empty if free
+    };
+
+    // Graph indice of a synset, throw on dangling offsets
+    int find_indice(const info_helper& info, int offset, pos_t pos)
+    {
+      int u = info.compute_indice(offset, pos);
+      if (u < 0)
+      {
+        std::ostringstream msg;
+        msg << "Unknown synset offset: " << offset << " (" << get_name_from_pos(pos) << ")";
+        throw std::runtime_error(msg.str());
+      }
+      return u;
+    }
+
+    /// Throw a parse error for the line [b, e) of fn
+    void malformed_line(const std::string& fn, const char* b, const char* e)
+    {
+      throw std::runtime_error("Malformed line in " + fn + ": " + std::string(b, e));
+    }
+
+    // Load synset's words (false on a truncated row)
+    bool load_data_row_words(scan::fields& srow, synset& synset, cat_buffer& buf)
+    {
+      if (!srow.hex(synset.w_cnt))
+        return false;
       for (std::size_t i = 0; i < synset.w_cnt; i++)
       {
         //word lex_id
 
-        std::string word;
-        srow >> word;
-        synset.words.push_back(word);
-
-        int lex_id;
-        srow >> std::hex >> lex_id >> std::dec;
-        synset.lex_ids.push_back(lex_id);
+        const char* b = 0;
+        const char* e = 0;
+        int lex_id = 0;
+        if (!srow.token(b, e) || !srow.hex(lex_id))
+          return false;
+        buf.words.push_back(string_ref(b, e - b));
+        buf.lex_ids.push_back(lex_id);
       }
+      return true;
     }
 
-    // Add rel to graph
-    void add_wordnet_rel(std::string& pointer_symbol_,// type of relation
+    // Add rel to buffer
+    void add_wordnet_rel(int pointer_symbol,           // type of relation
                          int synset_offset,           // dest offset
                          pos_t pos,                   // p.o.s. of dest
                          int src,                     // word src
                          int trgt,                    // word target
-                         synset& synset,              // source synset
-                         wordnet& wn,                 // our wordnet
-                         info_helper& info)           // helper
+                         cat_buffer& buf)             // our category
     {
       //if (pos == S || synset.pos == S)
       //  return; //FIXME: check where are s synsets.
 
-      int u = synset.id;
-      int v = info.compute_indice(synset_offset, pos);
-
-      ptr p;
-      p.pointer_symbol = info.get_symbol(pointer_symbol_);
-      p.source = src;
-      p.target = trgt;
+      rel r;
+      r.u = buf.synsets.size() - 1;
+      r.v_offset = synset_offset;
+      r.v_pos = pos;
+      r.v = -1;
+      r.p.pointer_symbol = pointer_symbol;
+      r.p.source = src;
+      r.p.target = trgt;
 
-      boost::add_edge(u,v, p, wn.wordnet_graph);
+      buf.rels.push_back(r);
     }
 
 
-    // load ptrs
-    void load_data_row_ptrs(std::stringstream& srow, synset& synset,
-                            wordnet& wn, info_helper& info)
+    // load ptrs (false on a truncated row)
+    bool load_data_row_ptrs(scan::fields& srow, synset& synset, cat_buffer& buf)
     {
-      srow >> synset.p_cnt;
+      if (!srow.dec(synset.p_cnt))
+        return false;
       for (std::size_t i = 0; i < synset.p_cnt; i++)
       {
         //http://wordnet.princeton.edu/wordnet/man/wndb.5WN.html#sect3
         //pointer_symbol  synset_offset  pos  source/target
-        std::string pointer_symbol_;
-        int   synset_offset;
-        pos_t pos;
-        int   src;
-        int   trgt;
-
-        srow >> pointer_symbol_;
-        srow >> synset_offset;
-
-        char c;
-        srow >> c;
-        pos = info.get_pos(c);
-
-        //print extracted edges
-        //std::cout << "(" << pointer_symbol << ", " << synset_offset;
-        //std::cout << ", " << pos << ")" << std::endl;
-
-        // Extract source/target words info
-        std::string src_trgt;
-        srow >> src_trgt;
-        std::stringstream ssrc(std::string(src_trgt,0,2));
-        std::stringstream strgt(std::string(src_trgt,2,2));
-        ssrc >> std::hex >> src >> std::dec;
-        strgt >> std::hex >> trgt >> std::dec;
-
-        add_wordnet_rel(pointer_symbol_, synset_offset, pos, src, trgt, synset, wn, info);
+        const char* ps_b = 0;
+        const char* ps_e = 0;
+        int   synset_offset = 0;
+        char  c = 0;
+        const char* st_b = 0;
+        const char* st_e = 0;
+        if (!srow.token(ps_b, ps_e) || !srow.dec(synset_offset) ||
+            !srow.chr(c) || !srow.token(st_b, st_e))
+          return false;
+        pos_t pos = get_pos_from_char(c);
+
+        // Extract source/target words info (4 hex digits: ssss tttt)
+        int src  = scan::hex_value(st_b, std::min(st_b + 2, st_e));
+        int trgt = scan::hex_value(std::min(st_b + 2, st_e), std::min(st_b + 4, st_e));
+
+        add_wordnet_rel(info_helper::get_symbol(ps_b, ps_e - ps_b), synset_offset,
+                        pos, src, trgt, buf);
       }
+      return true;
     }
 
 
-    // Load a synset and add it to the wordnet class.
-    void load_data_row(const std::string& row, wordnet& wn, info_helper& info)
+    // Load a synset and add it to the category buffer (false on a
+    // truncated row)
+    bool load_data_row(scan::fields& srow, cat_buffer& buf)
     {
       //http://wordnet.princeton.edu/wordnet/man/wndb.5WN.html#sect3
       // synset_offset lex_filenum ss_type w_cnt word lex_id [word lex_id...] p_cnt [ptr...] [frames...] | gloss
-      synset synset;
+      buf.synsets.push_back(synset());
+      synset& synset = buf.synsets.back();
 
-      std::stringstream srow(row);
-      int synset_offset;
-      srow >> synset_offset;
-      srow >> synset.lex_filenum;
-      char ss_type;
-      srow >> ss_type;
+      int  synset_offset = 0;
+      char ss_type = 0;
+      if (!srow.dec(synset_offset) || !srow.dec(synset.lex_filenum) ||
+          !srow.chr(ss_type))
+        return false;
+      buf.offsets.push_back(synset_offset);
 
-      // extra information
-      synset.pos = info.get_pos(ss_type);
-      synset.id  = info.compute_indice(synset_offset, synset.pos);
+      // extra information (id is set once all offsets are known)
+      synset.pos = get_pos_from_char(ss_type);
+      synset.id  = -1;
 
       // words
-      load_data_row_words(srow, synset);
+      if (!load_data_row_words(srow, synset, buf))
+        return false;
 
       // ptrs
-      load_data_row_ptrs(srow, synset, wn, info);
+      if (!load_data_row_ptrs(srow, synset, buf))
+        return false;
 
       //frames (skipped)
-      std::string tmp;
-      while (srow >> tmp)
-        if (tmp == "|")
+      const char* b = 0;
+      const char* e = 0;
+      while (srow.token(b, e))
+        if (e - b == 1 && *b == '|')
           break;
 
       // gloss
-      std::getline(srow, synset.gloss);
+      synset.gloss = string_ref(srow.cur, srow.end - srow.cur);
 
       // extra
       synset.sense_number = 0;
-
-      // Add synset to graph
-      wn.wordnet_graph[synset.id] = synset;
+      return true;
     }
 
 
     // Parse data.noun files
-    void load_wordnet_data(const std::string& fn, wordnet& wn, info_helper& info)
+    void load_wordnet_data(const std::string& fn, cat_buffer& buf)
     {
-      std::ifstream fin(fn.c_str());
-      if (!fin.is_open())
-        throw std::runtime_error("File missing: " + fn);
-
-      static const int MAX_LENGTH = 20480;
-      char row[MAX_LENGTH];
+      buf.data_file = mapped_file(fn);
+      scan::lines lines(buf.data_file.begin(), buf.data_file.end());
 
       //skip header
-      for(unsigned i = 0; i < 29; i++)
-        fin.getline(row, MAX_LENGTH);
+      lines.skip(29);
 
       //parse data line
-      while (fin.getline(row, MAX_LENGTH))
-        load_data_row(row, wn, info);
-
-      fin.close();
+      const char* b = 0;
+      const char* e = 0;
+      while (lines.next(b, e))
+      {
+        scan::fields srow(b, e);
+        if (!load_data_row(srow, buf))
+          malformed_line(fn, b, e);
+      }
     }
 
 
     //FIXME: It seems possible to replace synset_offsets with indice here.
-    void load_index_row(const std::string& row, wordnet& wn, info_helper& info)
+    // (false on a truncated row)
+    bool load_index_row(scan::fields& srow, cat_buffer& buf)
     {
       // lemma pos synset_cnt p_cnt [ptr_symbol...] sense_cnt tagsense_cnt synset_offset [synset_offset...]
-      index index;
-      std::stringstream srow(row);
-
-      char pos;
-      srow >> index.lemma;
-      srow >> pos;
-      index.pos = info.get_pos(pos); // extra data
-      srow >> index.synset_cnt;
-      srow >> index.p_cnt;
+      buf.indexes.push_back(index());
+      index& index = buf.indexes.back();
+
+      char pos = 0;
+      const char* b = 0;
+      const char* e = 0;
+      if (!srow.token(b, e) || !srow.chr(pos) ||
+          !srow.dec(index.synset_cnt) || !srow.dec(index.p_cnt))
+        return false;
+      index.lemma = string_ref(b, e - b);
+      index.pos = get_pos_from_char(pos); // extra data
 
-      std::string tmp_p;
       for (std::size_t i = 0; i < index.p_cnt; i++)
       {
-        srow >> tmp_p;
-        index.ptr_symbols.push_back(tmp_p);
+        b = e = 0;
+        if (!srow.token(b, e))
+          return false;
+        buf.ptr_symbols.push_back(string_ref(b, e - b));
       }
-      srow >> index.sense_cnt;
-      srow >> index.tagsense_cnt;
-
-      int tmp_o;
-      while (srow >> tmp_o)
-      {
-        index.synset_offsets.push_back(tmp_o);
-        index.synset_ids.push_back(info.compute_indice(tmp_o, index.pos)); // extra data
-      }
-
-      //add synset to index list
-      wn.index_list.push_back(index);
+      if (!srow.dec(index.sense_cnt) || !srow.dec(index.tagsense_cnt))
+        return false;
+
+      std::size_t n = 0;
+      int tmp_o = 0;
+      for (; srow.dec(tmp_o); n++)
+        buf.synset_offsets.push_back(tmp_o); // synset_ids set once resolved
+      buf.nb_offsets.push_back(n);
+      return true;
     }
 
 
-    void load_wordnet_index(const std::string& fn, wordnet& wn, info_helper& info)
+    void load_wordnet_index(const std::string& fn, cat_buffer& buf)
     {
-      std::ifstream fin(fn.c_str());
-      if (!fin.is_open())
-        throw std::runtime_error("File Not Found: " + fn);
-
-      static const int MAX_LENGTH = 20480;
-      char row[MAX_LENGTH];
+      buf.index_file = mapped_file(fn);
+      scan::lines lines(buf.index_file.begin(), buf.index_file.end());
 
       //skip header
       const unsigned int header_nb_lines = 29;
-      for(std::size_t i = 0; i < header_nb_lines; i++)
-        fin.getline(row, MAX_LENGTH);
+      lines.skip(header_nb_lines);
 
       //parse data line
-      while (fin.getline(row, MAX_LENGTH))
-        load_index_row(row, wn, info);
+      const char* b = 0;
+      const char* e = 0;
+      while (lines.next(b, e))
+      {
+        scan::fields srow(b, e);
+        if (!load_index_row(srow, buf))
+          malformed_line(fn, b, e);
+      }
+    }
+
 
-      fin.close();
+    void load_wordnet_exc(const std::string& dn, cat_buffer& buf)
+    {
+      std::string fn = dn + buf.cat + ".exc";
+      buf.exc_file = mapped_file(fn);
+      scan::lines lines(buf.exc_file.begin(), buf.exc_file.end());
+
+      const char* b = 0;
+      const char* e = 0;
+      while (lines.next(b, e))  // modified to read in multiple exceptions where they exist
+      {
+        scan::fields srow(b, e);
+        if (!srow.token(b, e))
+          continue;
+        string_ref key(b, e - b);
+        while (srow.token(b, e))
+          buf.exceptions.push_back(std::make_pair(key, string_ref(b, e - b)));
+      }
     }
 
+    void load_wordnet_cat(const std::string& dn, cat_buffer& buf)
+    {
+      load_wordnet_data((dn + "data." + buf.cat), buf);
+      load_wordnet_index((dn + "index." + buf.cat), buf);
+      load_wordnet_exc(dn, buf);
+    }
 
-    void load_wordnet_exc(const std::string& dn, std::string cat,
-                          wordnet& wn, info_helper&)
+    // Replace offsets by graph indices (info is complete and only read)
+    void resolve_wordnet_cat(cat_buffer& buf, const info_helper& info)
     {
-      std::string fn = dn + cat + ".exc";
-      std::ifstream fin(fn.c_str());
-      if (!fin.is_open())
-        throw std::runtime_error("File Not Found: " + fn);
+      for (std::size_t i = 0; i < buf.synsets.size(); i++)
+        buf.synsets[i].id = find_indice(info, buf.offsets[i], buf.synsets[i].pos);
 
-      std::map<std::string,std::vector<std::string> >& exc = wn.exc[get_pos_from_name(cat)];
+      for (std::size_t i = 0; i < buf.rels.size(); i++)
+      {
+        rel& r = buf.rels[i];
+        r.u = buf.synsets[r.u].id;
+        r.v = find_indice(info, r.v_offset, r.v_pos);
+      }
 
-      std::string row;
+      buf.synset_ids.resize(buf.synset_offsets.size());
+      for (std::size_t i = 0, k = 0; i < buf.indexes.size(); i++)
+        for (std::size_t end = k + buf.nb_offsets[i]; k < end; k++)
+          buf.synset_ids[k] = find_indice(info, buf.synset_offsets[k], buf.indexes[i].pos); // extra data
+    }
+
+    // Copy a parsed category into the wordnet
+    void merge_wordnet_cat(cat_buffer& buf, wordnet& wn, interner& intern,
+                           bool lazy_glosses)
+    {
+      arena& storage = wn.storage;
+
+      for (std::size_t i = 0, w = 0; i < buf.synsets.size(); i++)
+      {
+        synset& s = buf.synsets[i];
+        std::size_t first = storage.strings.size();
+        for (std::size_t k = 0; k < s.w_cnt; k++)
+          storage.strings.push_back(intern(buf.words[w + k]));
+        s.words   = storage.strings.range(first, storage.strings.size());
+        s.lex_ids = storage.ints.append(buf.lex_ids.begin() + w,
+                                        buf.lex_ids.begin() + w + s.w_cnt);
+        s.gloss   = lazy_glosses ? string_ref() : storage.add(s.gloss);
+        w += s.w_cnt;
+        wn.wordnet_graph[s.id] = s;
+      }
 
-      std::string key, value;
-      while (std::getline(fin, row))  // modified to read in multiple exceptions where they exist
+      for (std::size_t i = 0, p = 0, o = 0; i < buf.indexes.size(); i++)
       {
-        std::stringstream srow(row);
-        srow >> key;
-        srow >> value;
+        index& idx = buf.indexes[i];
+        idx.lemma = intern(idx.lemma);
+
+        std::size_t first = storage.strings.size();
+        for (std::size_t k = 0; k < idx.p_cnt; k++)
+          storage.strings.push_back(intern(buf.ptr_symbols[p + k]));
+        idx.ptr_symbols = storage.strings.range(first, storage.strings.size());
+        p += idx.p_cnt;
+
+        std::size_t n = buf.nb_offsets[i];
+        idx.synset_offsets = storage.ints.append(buf.synset_offsets.begin() + o,
+                                                 buf.synset_offsets.begin() + o + n);
+        idx.synset_ids     = storage.ints.append(buf.synset_ids.begin() + o,
+                                                 buf.synset_ids.begin() + o + n);
+        o += n;
+      }
+      wn.index_list.insert(wn.index_list.end(), buf.indexes.begin(), buf.indexes.end());
 
-        std::map<std::string,std::vector<std::string> >::iterator except = 
-            exc.insert( std::pair<std::string,std::vector<std::string> >(key,{value}) ).first;
+      pos_t pos = get_pos_from_name(buf.cat);
+      for (std::size_t i = 0; i < buf.exceptions.size(); i++)
+        wn.exc.add(pos, buf.exceptions[i].first, buf.exceptions[i].second);
 
-        while( srow >> value )
-        {
-          except->second.emplace_back( value );
-        }
+      if (lazy_glosses)
+      {
+        buf.data_file.evict();
+        wn.gloss_files[buf.pos] = std::move(buf.data_file);
       }
-    }
 
-    void load_wordnet_cat(const std::string dn, std::string cat,
-                          wordnet& wn, info_helper& info)
-    {
-      load_wordnet_data((dn + "data." + cat), wn, info);
-      load_wordnet_index((dn + "index." + cat), wn, info);
-      load_wordnet_exc(dn, cat, wn, info);
+      buf = cat_buffer();
     }
 
     // FIXME: this file is not in all packaged version of wordnet
-    void load_wordnet_index_sense(const std::string& dn, wordnet& wn, info_helper& info)
+    void load_wordnet_index_sense(const std::string& dn, sense_buffer& senses)
     {
       std::string fn = dn + "index.sense";
-      std::ifstream fin(fn.c_str());
-      if (!fin.is_open())
-        throw std::runtime_error("File Not Found: " + fn);
-
-      std::string row;
-      std::string sense_key;
-      int synset_offset;
-      while (std::getline(fin, row))
+      senses.file = mapped_file(fn);
+      scan::lines lines(senses.file.begin(), senses.file.end());
+
+      const char* b = 0;
+      const char* e = 0;
+      while (lines.next(b, e))
       {
-        std::stringstream srow(row);
-        srow >> sense_key;
+        scan::fields srow(b, e);
+
+        // sense_key: lemma%ss_type:lex_filenum:lex_id:head_word:head_id
+        const char* sk_b = 0;
+        const char* sk_e = 0;
+        if (!srow.token(sk_b, sk_e))
+          continue;
 
         // Get the pos of the lemma
-        std::vector<std::string> sk = ext::split(sense_key,'%');
-        std::string word = sk.at(0);
-        std::stringstream tmp(ext::split(sk.at(1), ':').at(0));
-        int ss_type;
-        tmp >> ss_type;
+        const char* pct = std::find(sk_b, sk_e, '%');
+        if (pct == sk_e)
+          throw std::runtime_error("Malformed sense key in " + fn + ": "
+                                   + std::string(sk_b, sk_e));
+        scan::fields tmp(pct + 1, sk_e);
+        int ss_type = 0;
+        if (!tmp.dec(ss_type))
+          throw std::runtime_error("Malformed sense key in " + fn + ": "
+                                   + std::string(sk_b, sk_e));
         pos_t pos =  (pos_t) ss_type;
 
-        srow >> synset_offset;
-
-        // Update synset info
-        int u = info.compute_indice(synset_offset, pos);
-        int sense_number;
-        srow >> sense_number;
-        wn.wordnet_graph[u].sense_number += sense_number;
-        int tag_cnt;
-        srow >> tag_cnt;
-        if (tag_cnt != 0)
-          wn.wordnet_graph[u].tag_cnts.push_back( make_pair(word,tag_cnt) );
-
-        //if (synset_offset == 2121620)
-        //  std::cout << u << " " << word << " " << synset_offset << " "
-        //            <<  wn.wordnet_graph[u].tag_cnt << " "
-        //            <<  wn.wordnet_graph[u].words[0] << std::endl;
+        // Update synset info (u is set once all offsets are known)
+        sense_rec rec;
+        rec.synset_offset = rec.sense_number = rec.tag_cnt = 0;
+        rec.pos = pos;
+        rec.u = -1;
+        if (!srow.dec(rec.synset_offset) || !srow.dec(rec.sense_number) ||
+            !srow.dec(rec.tag_cnt))
+          malformed_line(fn, b, e);
+        if (rec.tag_cnt != 0)
+          rec.word = string_ref(sk_b, pct - sk_b);
+        senses.recs.push_back(rec);
       }
     }
 
-    // wn -over used info in cntlist even if this is deprecated
-    // It is ok not to FIX and use this function
-    void load_wordnet_cntlist(const std::string& dn, wordnet& wn, info_helper& info)
+    void resolve_wordnet_index_sense(sense_buffer& senses, const info_helper& info)
     {
-      std::string fn = dn + "cntlist";
-      std::ifstream fin(fn.c_str());
-      if (!fin.is_open())
-        throw std::runtime_error("File Not Found: " + fn);
-
-      std::string sense_key;
-      int sense_number;
-      int tag_cnt;
+      for (std::size_t i = 0; i < senses.recs.size(); i++)
+        senses.recs[i].u = find_indice(info, senses.recs[i].synset_offset,
+                                       senses.recs[i].pos);
+    }
 
-      std::string row;
-      while (std::getline(fin, row))
+    void merge_wordnet_index_sense(sense_buffer& senses, wordnet& wn, interner& intern)
+    {
+      const std::vector<sense_rec>& recs = senses.recs;
+      wordnet::graph& g = wn.wordnet_graph;
+      std::size_t nb_synsets = boost::num_vertices(g);
+
+      // Tag counts of a synset are contiguous (in file order): count them
+      // per synset, then place them.
+      std::vector<std::size_t> first(nb_synsets + 1, 0);
+      for (std::size_t i = 0; i < recs.size(); i++)
       {
-        std::stringstream srow(row);
+        g[recs[i].u].sense_number += recs[i].sense_number;
+        if (recs[i].tag_cnt != 0)
+          first[recs[i].u + 1]++;
+      }
+      for (std::size_t u = 0; u < nb_synsets; u++)
+        first[u + 1] += first[u];
 
-        srow >> sense_key;
-        srow >> sense_number;
-        srow >> tag_cnt;
+      std::vector<arena::tag_cnt> tags(first.back());
+      std::vector<std::size_t>    next(first.begin(), first.end() - 1);
+      for (std::size_t i = 0; i < recs.size(); i++)
+        if (recs[i].tag_cnt != 0)
+          tags[next[recs[i].u]++] = std::make_pair(intern(recs[i].word), recs[i].tag_cnt);
 
-        // Get the pos of the lemma
-        std::string word = ext::split(sense_key,'%').at(0);
-        std::stringstream tmp(ext::split(ext::split(sense_key,'%').at(1), ':').at(0));
-        int ss_type;
-        tmp >> ss_type;
-        pos_t pos = (pos_t) ss_type;
-
-        // Update synset info
-        int synset_offset; // FIXME
-        int u = info.compute_indice(synset_offset, pos);
-        wn.wordnet_graph[u].sense_number += sense_number;
-        if (tag_cnt != 0)
-          wn.wordnet_graph[u].tag_cnts.push_back( make_pair(word,tag_cnt) );
+      std::size_t base = wn.storage.tags.size();
+      wn.storage.tags.append(tags.begin(), tags.end());
+      for (std::size_t u = 0; u < nb_synsets; u++)
+        g[u].tag_cnts = wn.storage.tags.range(base + first[u], base + first[u + 1]);
+
+      senses = sense_buffer();
+    }
+
+    // Size the arena of wn for the parsed buffers, return the number of
+    // strings to intern
+    std::size_t reserve_storage(const std::vector<cat_buffer>& bufs,
+                                const sense_buffer& senses, wordnet& wn,
+                                bool lazy_glosses)
+    {
+      std::size_t nb_chars = 0, nb_strings = 0, nb_ints = 0, nb_tags = 0;
+      for (std::size_t i = 0; i < bufs.size(); i++)
+      {
+        const cat_buffer& buf = bufs[i];
+        for (std::size_t k = 0; k < buf.synsets.size() && !lazy_glosses; k++)
+          nb_chars += buf.synsets[k].gloss.size();
+        for (std::size_t k = 0; k < buf.words.size(); k++)
+          nb_chars += buf.words[k].size();
+        for (std::size_t k = 0; k < buf.indexes.size(); k++)
+          nb_chars += buf.indexes[k].lemma.size();
+        for (std::size_t k = 0; k < buf.ptr_symbols.size(); k++)
+          nb_chars += buf.ptr_symbols[k].size();
+        nb_strings += buf.words.size() + buf.ptr_symbols.size();
+        nb_ints    += buf.lex_ids.size() + 2 * buf.synset_offsets.size();
       }
+      for (std::size_t i = 0; i < senses.recs.size(); i++)
+        if (senses.recs[i].tag_cnt != 0)
+        {
+          nb_chars += senses.recs[i].word.size();
+          nb_tags++;
+        }
+
+      // upper bounds: equal strings are only stored once
+      wn.storage.chars.reset(nb_chars);
+      wn.storage.strings.reset(nb_strings);
+      wn.storage.ints.reset(nb_ints);
+      wn.storage.tags.reset(nb_tags);
+
+      std::size_t nb_lemmas = 0;
+      for (std::size_t i = 0; i < bufs.size(); i++)
+        nb_lemmas += bufs[i].indexes.size();
+      return nb_strings + nb_lemmas + nb_tags;
     }
 
   } // end of anonymous namespace
 
   void load_wordnet(const std::string& dn, wordnet& wn, info_helper& info)
   {
+    load_wordnet(dn, wn, info, load_options());
+  }
+
+  void load_wordnet(const std::string& dn, wordnet& wn, info_helper& info,
+                    unsigned nb_threads)
+  {
+    load_options options;
+    options.nb_threads = nb_threads;
+    load_wordnet(dn, wn, info, options);
+  }
+
+  void load_wordnet(const std::string& dn, wordnet& wn, info_helper& info,
+                    const load_options& options)
+  {
+    unsigned nb_threads = options.nb_threads;
     // vertex added in this order a n r v
+    static const char* cats[] = { "adj", "noun", "adv", "verb" };
+    static const std::size_t nb_cats = sizeof(cats) / sizeof(cats[0]);
 
-    std::string fn = dn;
+    std::vector<cat_buffer> bufs(nb_cats);
+    sense_buffer            senses;
+    for (std::size_t i = 0; i < nb_cats; i++)
+    {
+      bufs[i].cat = cats[i];
+      bufs[i].pos = get_pos_from_name(cats[i]);
+    }
+
+    // Each file is read once: offsets are recorded while parsing and only
+    // resolved to graph indices when every data file has been read.
+    auto parse = [&](std::size_t i)
+      {
+        if (i < nb_cats)
+          load_wordnet_cat(dn, bufs[i]);
+        else
+          load_wordnet_index_sense(dn, senses);
+      };
+
+    auto build_info = [&]()
+      {
+        info = info_helper();
+        for (std::size_t i = 0; i < nb_cats; i++)
+          info.set_offsets(bufs[i].pos, bufs[i].offsets);
+      };
+
+    // Resolution jobs only read info
+    const info_helper& cinfo = info;
+    auto resolve = [&](std::size_t i)
+      {
+        if (i < nb_cats)
+          resolve_wordnet_cat(bufs[i], cinfo);
+        else
+          resolve_wordnet_index_sense(senses, cinfo);
+      };
+
+    // Merge, always in the same order so that the result does not depend
+    // on the number of threads.
+    auto merge = [&](boost::progress_display* show_progress)
+      {
+        wn.index_list.clear();
+        for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+          wn.gloss_files[p] = mapped_file();
+        {
+          std::size_t nb_edges = 0;
+          for (std::size_t i = 0; i < nb_cats; i++)
+            nb_edges += bufs[i].rels.size();
+
+          std::vector<graph_edge> edges;
+          edges.reserve(nb_edges);
+          for (std::size_t i = 0; i < nb_cats; i++)
+            for (std::size_t k = 0; k < bufs[i].rels.size(); k++)
+            {
+              const rel& r = bufs[i].rels[k];
+              graph_edge e = { (unsigned)r.u, (unsigned)r.v, r.p };
+              edges.push_back(e);
+            }
+          wn.build_graph(info.nb_synsets(), edges);
+        }
+        interner intern(wn.storage,
+                        reserve_storage(bufs, senses, wn, options.lazy_glosses),
+                        options.intern_strings);
+        wn.exc.clear();
+        for (std::size_t i = 0; i < nb_cats; i++)
+        {
+          merge_wordnet_cat(bufs[i], wn, intern, options.lazy_glosses);
+          if (show_progress)
+            ++(*show_progress);
+        }
+        wn.exc.build();
+        merge_wordnet_index_sense(senses, wn, intern);
+        if (show_progress)
+          ++(*show_progress);
+      };
 
     if (wn._verbose)
     {
       std::cout << std::endl;
       std::cout << "### Loading Wordnet 3.0";
-      boost::progress_display show_progress(5);
+      boost::progress_display show_progress(nb_cats + 1);
       boost::progress_timer t;
 
-      load_wordnet_cat(dn, "adj", wn, info);
-      ++show_progress;
-      load_wordnet_cat(dn, "noun", wn, info);
-      ++show_progress;
-      load_wordnet_cat(dn, "adv", wn, info);
-      ++show_progress;
-      load_wordnet_cat(dn, "verb", wn, info);
-      ++show_progress;
-      load_wordnet_index_sense(dn, wn, info);
-      ++show_progress;
+      run_jobs(nb_cats + 1, nb_threads, parse);
+      build_info();
+      run_jobs(nb_cats + 1, nb_threads, resolve);
+      merge(&show_progress);
       std::cout << std::endl;
     }
     else
     {
-      load_wordnet_cat(dn, "adj", wn, info);
-      load_wordnet_cat(dn, "noun", wn, info);
-      load_wordnet_cat(dn, "adv", wn, info);
-      load_wordnet_cat(dn, "verb", wn, info);
-      load_wordnet_index_sense(dn, wn, info);
+      run_jobs(nb_cats + 1, nb_threads, parse);
+      build_info();
+      run_jobs(nb_cats + 1, nb_threads, resolve);
+      merge(0);
     }
 
     std::stable_sort(wn.index_list.begin(), wn.index_list.end());
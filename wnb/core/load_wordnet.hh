@@ -8,8 +8,36 @@ namespace wnb
   /// forward declaration
   struct wordnet;
 
+  /// Options of the text database loader
+  struct load_options
+  {
+    load_options()
+      : verbose(false), nb_threads(1), intern_strings(false), lazy_glosses(false)
+    { }
+
+    bool     verbose;
+    /// Threads parsing the per-category files (1: serial, 0: one per core).
+    /// The loaded wordnet does not depend on this value.
+    unsigned nb_threads;
+    /// Store equal words, lemmas and pointer symbols once in the arena
+    /// (smaller arena, slower loading)
+    bool     intern_strings;
+    /// Leave synset::gloss empty, wordnet::gloss() reads glosses from the
+    /// data files, kept mapped
+    bool     lazy_glosses;
+  };
+
   /// Load the entire wordnet data base located in \p dn (typically .../dict/)
+  /// Every file is read once; \p info and the graph of \p wn are rebuilt.
   void load_wordnet(const std::string& dn, wordnet& wn, info_helper& info);
+
+  /// Same as above, parsing the categories on up to \p nb_threads threads
+  void load_wordnet(const std::string& dn, wordnet& wn, info_helper& info,
+                    unsigned nb_threads);
+
+  /// Same as above, with every loading option
+  void load_wordnet(const std::string& dn, wordnet& wn, info_helper& info,
+                    const load_options& options);
 }
 
 #endif /* _LOAD_WORDNET_HH */
@@ -0,0 +1,147 @@
+#include "mapped_file.hh"
+
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace wnb
+{
+
+  mapped_file::mapped_file(const std::string& fn)
+    : _data(0), _size(0), _fn(fn)
+  {
+    int fd = ::open(fn.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("File not found: " + fn);
+
+    struct stat st;
+    if (::fstat(fd, &st) < 0)
+    {
+      ::close(fd);
+      throw std::runtime_error("Cannot stat file: " + fn);
+    }
+
+    // mmap refuses zero-length mappings, an empty file is an empty range
+    if (st.st_size > 0)
+    {
+      void* p = ::mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED)
+      {
+        ::close(fd);
+        throw std::runtime_error("Cannot map file: " + fn);
+      }
+      ::madvise(p, st.st_size, MADV_SEQUENTIAL);
+      _data = static_cast<const char*>(p);
+      _size = st.st_size;
+    }
+
+    // the mapping stays valid once the descriptor is closed
+    ::close(fd);
+  }
+
+  mapped_file::mapped_file(const mapped_file& other)
+    : _data(0), _size(0)
+  {
+    *this = other;
+  }
+
+  mapped_file&
+  mapped_file::operator=(const mapped_file& other)
+  {
+    if (this != &other)
+    {
+      if (other._fn.empty())
+      {
+        unmap();
+        _fn.clear();
+      }
+      else
+        *this = mapped_file(other._fn);
+    }
+    return *this;
+  }
+
+  mapped_file::mapped_file(mapped_file&& other)
+    : _data(other._data), _size(other._size), _fn(std::move(other._fn))
+  {
+    other._data = 0;
+    other._size = 0;
+    other._fn.clear();
+  }
+
+  mapped_file&
+  mapped_file::operator=(mapped_file&& other)
+  {
+    if (this != &other)
+    {
+      unmap();
+      _data = other._data;
+      _size = other._size;
+      _fn.swap(other._fn);
+      other._data = 0;
+      other._size = 0;
+      other._fn.clear();
+    }
+    return *this;
+  }
+
+  mapped_file::~mapped_file()
+  {
+    unmap();
+  }
+
+  void
+  mapped_file::evict() const
+  {
+    if (_data)
+      ::madvise(const_cast<char*>(_data), _size, MADV_DONTNEED);
+  }
+
+  void
+  mapped_file::unmap()
+  {
+    if (_data)
+      ::munmap(const_cast<char*>(_data), _size);
+    _data = 0;
+    _size = 0;
+  }
+
+
+  mapped_output::mapped_output(const std::string& fn, std::size_t size)
+    : _data(0), _size(size)
+  {
+    int fd = ::open(fn.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      throw std::runtime_error("Cannot create file: " + fn);
+
+    if (::ftruncate(fd, size) < 0)
+    {
+      ::close(fd);
+      throw std::runtime_error("Cannot resize file: " + fn);
+    }
+
+    if (size > 0)
+    {
+      void* p = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED)
+      {
+        ::close(fd);
+        throw std::runtime_error("Cannot map file: " + fn);
+      }
+      _data = static_cast<char*>(p);
+    }
+
+    ::close(fd);
+  }
+
+  mapped_output::~mapped_output()
+  {
+    if (_data)
+      ::munmap(_data, _size);
+  }
+
+} // end of namespace wnb
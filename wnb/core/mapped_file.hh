@@ -0,0 +1,68 @@
+#ifndef _MAPPED_FILE_HH
+# define _MAPPED_FILE_HH
+
+# include <string>
+# include <cstddef>
+
+namespace wnb
+{
+
+  /// Read-only memory mapping of a whole file (POSIX mmap)
+  class mapped_file
+  {
+  public:
+    mapped_file() : _data(0), _size(0) { }
+
+    /// Map fn, throw std::runtime_error if it cannot be opened
+    explicit mapped_file(const std::string& fn);
+
+    /// Map the file of other again
+    mapped_file(const mapped_file& other);
+    mapped_file& operator=(const mapped_file& other);
+
+    mapped_file(mapped_file&& other);
+    mapped_file& operator=(mapped_file&& other);
+    ~mapped_file();
+
+    const char* begin() const { return _data; }
+    const char* end()   const { return _data + _size; }
+    std::size_t size()  const { return _size; }
+    bool        empty() const { return _size == 0; }
+    const std::string& path() const { return _fn; }
+
+    /// Drop the resident pages, they are read again on access
+    void evict() const;
+
+  private:
+    void unmap();
+
+    const char* _data;
+    std::size_t _size;
+    std::string _fn;
+  };
+
+
+  /// Read-write shared memory mapping of a new file of a given size
+  /// (written back by the system, may be larger than memory)
+  class mapped_output
+  {
+  public:
+    /// Create (or truncate) fn to size bytes and map it, throw
+    /// std::runtime_error if it cannot be done
+    mapped_output(const std::string& fn, std::size_t size);
+    ~mapped_output();
+
+    char*       begin() const { return _data; }
+    std::size_t size()  const { return _size; }
+
+  private:
+    mapped_output(const mapped_output&);            // non copyable
+    mapped_output& operator=(const mapped_output&);
+
+    char*       _data;
+    std::size_t _size;
+  };
+
+} // end of namespace wnb
+
+#endif /* _MAPPED_FILE_HH */
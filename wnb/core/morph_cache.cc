@@ -0,0 +1,65 @@
+#include "morph_cache.hh"
+#include "arena.hh"
+
+#include <cstring>
+
+namespace wnb
+{
+
+  bool
+  morph_cache::key::operator==(const key& k) const
+  {
+    return pos == k.pos && size == k.size && std::memcmp(form, k.form, size) == 0;
+  }
+
+  uint64_t
+  morph_cache::key_hash::operator()(const key& k) const
+  {
+    uint64_t h = (uint64_t(string_hash(string_ref(k.form, k.size))) << 3) ^ k.pos;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+  }
+
+  bool
+  morph_cache::make_key(string_ref form, pos_t pos, key& k)
+  {
+    if (form.size() > MAX_FORM)
+      return false;
+    k.pos  = pos;
+    k.size = form.size();
+    std::memcpy(k.form, form.data(), form.size());
+    return true;
+  }
+
+  bool
+  morph_cache::find(string_ref form, pos_t pos, string_ref& base) const
+  {
+    key   k;
+    value v;
+    if (!make_key(form, pos, k) || !_lru.find(k, v))
+      return false;
+    base = string_ref(v.base, v.size);
+    return true;
+  }
+
+  void
+  morph_cache::insert(string_ref form, pos_t pos, string_ref base)
+  {
+    key   k;
+    value v;
+    if (!make_key(form, pos, k))
+      return;
+    v.base = base.data();
+    v.size = base.size();
+    _lru.insert(k, v);
+  }
+
+  morph_cache::statistics
+  morph_cache::stats() const
+  {
+    sharded_lru<key, value, key_hash>::statistics s = _lru.stats();
+    statistics st = { s.hits, s.misses, s.evictions };
+    return st;
+  }
+
+} // end of namespace wnb
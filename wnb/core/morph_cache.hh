@@ -0,0 +1,83 @@
+#ifndef _MORPH_CACHE_HH
+# define _MORPH_CACHE_HH
+
+# include <string>
+# include <cstddef>
+
+# include <stdint.h>
+
+# include "pos_t.hh"
+# include "arena.hh"
+# include "sharded_lru.hh"
+
+namespace wnb
+{
+
+  /// Bounded, thread safe cache of base forms (wordnet::morphword) of
+  /// (form, pos) pairs, forms without base form included (empty base).
+  /// Base forms are kept as views of the lemmas of the wordnet, which
+  /// must outlive the cache.
+  ///
+  /// A sharded_lru of fixed size records: lookups take no lock and copy
+  /// nothing but the record. Forms over MAX_FORM characters are not
+  /// cached.
+  class morph_cache
+  {
+  public:
+    static const std::size_t MAX_FORM = 30;
+
+    /// Counters, summed over the shards
+    struct statistics
+    {
+      std::size_t hits;
+      std::size_t misses;
+      std::size_t evictions;
+    };
+
+    /// Keep (about) capacity pairs, in nb_shards shards (rounded up to a
+    /// power of 2)
+    morph_cache(std::size_t capacity, std::size_t nb_shards = 16)
+      : _lru(capacity, nb_shards)
+    { }
+
+    /// Cached base of (form, pos), counted as a hit or a miss
+    bool find(string_ref form, pos_t pos, string_ref& base) const;
+
+    /// Cache the base of (form, pos), evicting a pair not used recently
+    void insert(string_ref form, pos_t pos, string_ref base);
+
+    statistics stats() const;
+
+    /// Drop every pair (counters are kept)
+    void clear() { _lru.clear(); }
+
+  private:
+    struct key
+    {
+      uint8_t pos;
+      uint8_t size;
+      char    form[MAX_FORM];
+
+      bool operator==(const key& k) const;
+    };
+
+    struct value
+    {
+      const char* base;
+      std::size_t size;
+    };
+
+    struct key_hash
+    {
+      uint64_t operator()(const key& k) const;
+    };
+
+    /// Key of (form, pos), false if form is too long
+    static bool make_key(string_ref form, pos_t pos, key& k);
+
+    sharded_lru<key, value, key_hash> _lru;
+  };
+
+} // end of namespace wnb
+
+#endif /* _MORPH_CACHE_HH */
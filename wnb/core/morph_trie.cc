@@ -0,0 +1,66 @@
+#include "morph_trie.hh"
+
+#include <stdexcept>
+
+namespace wnb
+{
+
+  void
+  morph_trie::clear()
+  {
+    node root = { 0, none, none, 0 };
+    nodes.assign(1, root);
+    suffixes.clear();
+    additions.clear();
+  }
+
+  bool
+  morph_trie::compilable(const rules_t& rules)
+  {
+    if (rules.size() > max_rules)
+      return false;
+    for (std::size_t i = 0; i < rules.size(); i++)
+      if (rules[i].second.size() > rules[i].first.size())
+        return false;
+    return true;
+  }
+
+  void
+  morph_trie::build(const rules_t& rules)
+  {
+    clear();
+    if (rules.size() > max_rules)
+      throw std::runtime_error("Too many morphological rules");
+
+    for (std::size_t i = 0; i < rules.size(); i++)
+    {
+      const std::string& suffix = rules[i].first;
+      if (rules[i].second.size() > suffix.size())
+        throw std::runtime_error("Morphological rule adding more than it removes: "
+                                 + suffix + " -> " + rules[i].second);
+
+      // suffix read backwards, from the root
+      uint32_t n = 0;
+      for (std::size_t k = suffix.size(); k > 0; k--)
+      {
+        char c = suffix[k - 1];
+        uint32_t child = nodes[n].first_child;
+        while (child != none && nodes[child].c != c)
+          child = nodes[child].next_sibling;
+        if (child == none)
+        {
+          node leaf = { c, none, nodes[n].first_child, 0 };
+          child = nodes.size();
+          nodes[n].first_child = child;
+          nodes.push_back(leaf);
+        }
+        n = child;
+      }
+      nodes[n].rules |= uint64_t(1) << i;
+
+      suffixes.push_back(suffix);
+      additions.push_back(rules[i].second);
+    }
+  }
+
+} // end of namespace wnb
@@ -0,0 +1,80 @@
+#ifndef _MORPH_TRIE_HH
+# define _MORPH_TRIE_HH
+
+# include <string>
+# include <vector>
+# include <utility>
+# include <cstddef>
+
+# include <stdint.h>
+
+namespace wnb
+{
+
+  /// Morphological rules of a pos (suffix -> addition) compiled to a trie
+  /// of reversed suffixes: a single walk from the end of a word gives
+  /// every rule whose suffix it ends with.
+  class morph_trie
+  {
+  public:
+    typedef std::vector<std::pair<std::string, std::string> > rules_t;
+
+    /// Bits of a match mask
+    static const std::size_t max_rules = 64;
+
+    morph_trie() { clear(); }
+
+    /// False if there are more than max_rules or if an addition is longer
+    /// than its suffix (forms must not grow)
+    static bool compilable(const rules_t& rules);
+
+    /// Compile rules, throw std::runtime_error unless compilable(rules)
+    void build(const rules_t& rules);
+
+    void clear();
+
+    /// Rules applying to the word [b, e), shorter than it (bit i: rule i)
+    uint64_t match(const char* b, const char* e) const
+    {
+      if (b == e)
+        return 0;
+
+      uint64_t rules = nodes[0].rules;
+      uint32_t n = 0;
+      for (const char* p = e; p != b; )
+      {
+        --p;
+        for (n = nodes[n].first_child; n != none && nodes[n].c != *p;
+             n = nodes[n].next_sibling)
+          ;
+        if (n == none)
+          break;
+        if (p != b)
+          rules |= nodes[n].rules;
+      }
+      return rules;
+    }
+
+    std::size_t        size()                const { return suffixes.size(); }
+    const std::string& suffix(std::size_t i)   const { return suffixes[i]; }
+    const std::string& addition(std::size_t i) const { return additions[i]; }
+
+  private:
+    static const uint32_t none = uint32_t(-1);
+
+    struct node
+    {
+      char     c;            ///< last character read
+      uint32_t first_child;
+      uint32_t next_sibling;
+      uint64_t rules;        ///< rules whose suffix ends here
+    };
+
+    std::vector<node>        nodes; ///< root first
+    std::vector<std::string> suffixes;
+    std::vector<std::string> additions;
+  };
+
+} // end of namespace wnb
+
+#endif /* _MORPH_TRIE_HH */
@@ -0,0 +1,64 @@
+#ifndef _RUN_JOBS_HH
+# define _RUN_JOBS_HH
+
+# include <vector>
+# include <algorithm>
+# include <thread>
+# include <atomic>
+# include <exception>
+
+namespace wnb
+{
+
+  /// Number of threads running nb_jobs jobs on nb_threads threads
+  /// (0: one per core)
+  inline unsigned job_threads(std::size_t nb_jobs, unsigned nb_threads)
+  {
+    if (nb_threads == 0)
+      nb_threads = std::max(1u, std::thread::hardware_concurrency());
+    return std::min<std::size_t>(nb_threads, nb_jobs);
+  }
+
+  /// Run jobs 0..nb_jobs-1 on job_threads(nb_jobs, nb_threads) threads,
+  /// calling job(i, t) where t is the index of the running thread (e.g. for
+  /// per-thread buffers). Rethrow the first exception raised by a job.
+  /// Idle threads take the next job, so uneven jobs are balanced.
+  template <typename Job>
+  void run_thread_jobs(std::size_t nb_jobs, unsigned nb_threads, Job job)
+  {
+    nb_threads = job_threads(nb_jobs, nb_threads);
+
+    std::atomic<std::size_t> next(0);
+    std::vector<std::exception_ptr> errors(nb_jobs);
+    auto worker = [&](unsigned t)
+      {
+        for (std::size_t i; (i = next++) < nb_jobs; )
+        {
+          try { job(i, t); }
+          catch (...) { errors[i] = std::current_exception(); }
+        }
+      };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < nb_threads; t++)
+      threads.push_back(std::thread(worker, t));
+    worker(0);
+    for (std::size_t t = 0; t < threads.size(); t++)
+      threads[t].join();
+
+    for (std::size_t i = 0; i < nb_jobs; i++)
+      if (errors[i])
+        std::rethrow_exception(errors[i]);
+  }
+
+  /// Same as run_thread_jobs, calling job(i)
+  template <typename Job>
+  void run_jobs(std::size_t nb_jobs, unsigned nb_threads, Job job)
+  {
+    run_thread_jobs(nb_jobs, nb_threads,
+                    [&job](std::size_t i, unsigned) { job(i); });
+  }
+
+} // end of namespace wnb
+
+#endif /* _RUN_JOBS_HH */
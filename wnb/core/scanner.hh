@@ -0,0 +1,155 @@
+#ifndef _SCANNER_HH
+# define _SCANNER_HH
+
+# include <string>
+# include <cstring>
+# include <cstddef>
+
+namespace wnb
+{
+  namespace scan // in-place parsing of wordnet text files
+  {
+
+    inline bool is_space(char c)
+    {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r'
+        || c == '\v' || c == '\f';
+    }
+
+    /// Value of an hexadecimal digit, -1 if c is not one
+    inline int hex_digit(char c)
+    {
+      if (c >= '0' && c <= '9') return c - '0';
+      if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+      return -1;
+    }
+
+    /// Value of the hexadecimal number [b, e) (e.g. 2 digits of source/target)
+    inline int hex_value(const char* b, const char* e)
+    {
+      int v = 0;
+      for (; b != e; ++b)
+      {
+        int d = hex_digit(*b);
+        if (d < 0)
+          break;
+        v = v * 16 + d;
+      }
+      return v;
+    }
+
+    /// Iterate over the lines of a buffer ('\n' is not part of the line)
+    struct lines
+    {
+      lines(const char* b, const char* e) : cur(b), end(e) { }
+
+      bool next(const char*& b, const char*& e)
+      {
+        if (cur == end)
+          return false;
+        b = cur;
+        e = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+        if (e == 0)
+          e = end;
+        cur = (e == end) ? end : e + 1;
+        return true;
+      }
+
+      /// Skip n lines (e.g. the license header of data/index files)
+      void skip(std::size_t n)
+      {
+        const char* b;
+        const char* e;
+        for (std::size_t i = 0; i < n && next(b, e); i++)
+          ;
+      }
+
+      const char* cur;
+      const char* end;
+    };
+
+    /// Whitespace separated fields of a line, read like operator>> would
+    struct fields
+    {
+      fields(const char* b, const char* e) : cur(b), end(e) { }
+
+      void skip_ws()
+      {
+        while (cur != end && is_space(*cur))
+          ++cur;
+      }
+
+      bool token(const char*& b, const char*& e)
+      {
+        skip_ws();
+        if (cur == end)
+          return false;
+        b = cur;
+        while (cur != end && !is_space(*cur))
+          ++cur;
+        e = cur;
+        return true;
+      }
+
+      bool token(std::string& s)
+      {
+        const char* b;
+        const char* e;
+        if (!token(b, e))
+          return false;
+        s.assign(b, e);
+        return true;
+      }
+
+      bool chr(char& c)
+      {
+        skip_ws();
+        if (cur == end)
+          return false;
+        c = *cur++;
+        return true;
+      }
+
+      template <typename T>
+      bool dec(T& v)
+      {
+        skip_ws();
+        const char* p = cur;
+        bool neg = (p != end && *p == '-');
+        if (neg || (p != end && *p == '+'))
+          ++p;
+        if (p == end || *p < '0' || *p > '9')
+          return false;
+        long long n = 0;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p)
+          n = n * 10 + (*p - '0');
+        v = static_cast<T>(neg ? -n : n);
+        cur = p;
+        return true;
+      }
+
+      template <typename T>
+      bool hex(T& v)
+      {
+        skip_ws();
+        const char* p = cur;
+        if (p == end || hex_digit(*p) < 0)
+          return false;
+        long long n = 0;
+        for (int d; p != end && (d = hex_digit(*p)) >= 0; ++p)
+          n = n * 16 + d;
+        v = static_cast<T>(n);
+        cur = p;
+        return true;
+      }
+
+      const char* cur;
+      const char* end;
+    };
+
+  } // end of namespace wnb::scan
+
+} // end of namespace wnb
+
+#endif /* _SCANNER_HH */
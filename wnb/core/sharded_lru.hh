@@ -0,0 +1,317 @@
+#ifndef _SHARDED_LRU_HH
+# define _SHARDED_LRU_HH
+
+# include <vector>
+# include <atomic>
+# include <mutex>
+# include <cstring>
+# include <cstddef>
+# include <type_traits>
+
+# include <stdint.h>
+
+namespace wnb
+{
+
+  /// Stripe of the per-thread counters of the calling thread (numbered
+  /// from 1 on first call, no initialization guard on the next ones)
+  inline std::size_t thread_stripe()
+  {
+    static std::atomic<std::size_t> last(0);
+    static thread_local std::size_t stripe = 0;
+    if (!stripe)
+      stripe = ++last;
+    return stripe;
+  }
+
+
+  /// Bounded, thread safe cache of key -> value, evicting (about) the
+  /// least recently used pairs (CLOCK).
+  ///
+  /// Key and Value are trivially copyable (fixed size records), Hash gives
+  /// a 64 bits hash of a key. Pairs are kept in sets of WAYS entries spread
+  /// over shards. Lookups take no lock: each entry is a seqlock (a reader
+  /// retries nothing, a concurrent write is a miss), a hit only sets the
+  /// CLOCK bit of its entry if it is clear and counts in the counters of
+  /// its thread (striped). Insertions lock their shard.
+  template <typename Key, typename Value, typename Hash>
+  class sharded_lru
+  {
+  public:
+    static_assert(std::is_trivially_copyable<Key>::value &&
+                  std::is_trivially_copyable<Value>::value,
+                  "sharded_lru: keys and values are copied as bytes");
+
+    static const std::size_t WAYS = 8; ///< entries per set
+
+    /// Counters, summed over the shards
+    struct statistics
+    {
+      std::size_t hits;
+      std::size_t misses;
+      std::size_t evictions;
+    };
+
+    /// Keep (about) capacity pairs, in nb_shards shards (rounded up to a
+    /// power of 2)
+    sharded_lru(std::size_t capacity, std::size_t nb_shards = 16);
+
+    /// Copy the cached value of key to value (once), counted as a hit or
+    /// a miss
+    bool find(const Key& key, Value& value) const;
+
+    /// Cache the value of key, evicting a pair of its set if full
+    void insert(const Key& key, const Value& value);
+
+    statistics  stats() const;
+    std::size_t capacity() const { return shards.size() * sets_per_shard * WAYS; }
+
+    /// Drop every pair (counters are kept)
+    void clear();
+
+  private:
+    struct record
+    {
+      Key   key;
+      Value value;
+    };
+
+    static const std::size_t NB_WORDS = (sizeof(record) + 7) / 8;
+
+    struct entry
+    {
+      std::atomic<uint32_t> version;    ///< odd while written
+      mutable std::atomic<uint32_t> referenced; ///< CLOCK bit
+      std::atomic<uint64_t> words[NB_WORDS]; ///< the record
+    };
+
+    /// Tags first: a lookup reads one line, then the entry of its tag
+    struct set
+    {
+      std::atomic<uint32_t> tags[WAYS]; ///< high hash bits | 1, 0 if empty
+      entry                 ways[WAYS];
+      unsigned              hand; ///< next CLOCK victim (under the shard lock)
+    };
+
+    struct shard
+    {
+      mutable std::mutex lock;
+      std::vector<set>   sets;
+      std::size_t        evictions;
+    };
+
+    /// Counters of the threads of a stripe, one cache line each
+    struct counters
+    {
+      std::atomic<std::size_t> hits;
+      std::atomic<std::size_t> misses;
+      char                     padding[64 - 2 * sizeof(std::atomic<std::size_t>)];
+    };
+    static const std::size_t NB_STRIPES = 64;
+
+    const set& set_of(uint64_t h) const
+    {
+      const shard& s = shards[h & (shards.size() - 1)];
+      return s.sets[(h >> shard_bits) & (sets_per_shard - 1)];
+    }
+
+    static bool read(const entry& e, record& r);
+    static void write(set& s, std::size_t w, uint32_t tag, const record& r);
+
+    std::vector<shard>    shards;
+    unsigned              shard_bits; ///< low hash bits selecting the shard
+    std::size_t           sets_per_shard;
+    mutable counters      stripes[NB_STRIPES];
+    Hash                  hash;
+
+    sharded_lru(const sharded_lru&);            // non copyable
+    sharded_lru& operator=(const sharded_lru&);
+  };
+
+
+  template <typename Key, typename Value, typename Hash>
+  sharded_lru<Key, Value, Hash>::sharded_lru(std::size_t capacity,
+                                             std::size_t nb_shards)
+    : shard_bits(0), sets_per_shard(1)
+  {
+    std::size_t n = 1;
+    while (n < nb_shards)
+    {
+      n *= 2;
+      shard_bits++;
+    }
+    while (n * sets_per_shard * WAYS < capacity)
+      sets_per_shard *= 2;
+
+    std::vector<shard>(n).swap(shards);
+    for (std::size_t i = 0; i < n; i++)
+    {
+      std::vector<set>(sets_per_shard).swap(shards[i].sets);
+      shards[i].evictions = 0;
+    }
+    for (std::size_t i = 0; i < NB_STRIPES; i++)
+      stripes[i].hits = stripes[i].misses = 0;
+    clear();
+  }
+
+
+  /// Seqlock read of the record of e (false if it is being written)
+  template <typename Key, typename Value, typename Hash>
+  bool
+  sharded_lru<Key, Value, Hash>::read(const entry& e, record& r)
+  {
+    uint32_t v = e.version.load(std::memory_order_acquire);
+    if (v & 1)
+      return false;
+
+    uint64_t words[NB_WORDS];
+    for (std::size_t k = 0; k < NB_WORDS; k++)
+      words[k] = e.words[k].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (e.version.load(std::memory_order_relaxed) != v)
+      return false;
+
+    std::memcpy(&r, words, sizeof(record));
+    return true;
+  }
+
+
+  /// Seqlock write of the entry w of s and its tag (under the shard lock)
+  template <typename Key, typename Value, typename Hash>
+  void
+  sharded_lru<Key, Value, Hash>::write(set& s, std::size_t w, uint32_t tag,
+                                       const record& r)
+  {
+    uint64_t words[NB_WORDS] = { 0 };
+    std::memcpy(words, &r, sizeof(record));
+
+    entry&   e = s.ways[w];
+    uint32_t v = e.version.load(std::memory_order_relaxed);
+    e.version.store(v + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.tags[w].store(tag, std::memory_order_relaxed);
+    for (std::size_t k = 0; k < NB_WORDS; k++)
+      e.words[k].store(words[k], std::memory_order_relaxed);
+    e.version.store(v + 2, std::memory_order_release);
+  }
+
+
+  template <typename Key, typename Value, typename Hash>
+  bool
+  sharded_lru<Key, Value, Hash>::find(const Key& key, Value& value) const
+  {
+    uint64_t   h   = hash(key);
+    uint32_t   tag = uint32_t(h >> 32) | 1;
+    const set& s   = set_of(h);
+    counters&  c   = stripes[thread_stripe() & (NB_STRIPES - 1)];
+
+    record r;
+    for (std::size_t w = 0; w < WAYS; w++)
+    {
+      // the tag may be stale, the key read is checked
+      const entry& e = s.ways[w];
+      if (s.tags[w].load(std::memory_order_relaxed) == tag &&
+          read(e, r) && r.key == key)
+      {
+        if (!e.referenced.load(std::memory_order_relaxed))
+          e.referenced.store(1, std::memory_order_relaxed);
+        c.hits.fetch_add(1, std::memory_order_relaxed);
+        value = r.value;
+        return true;
+      }
+    }
+    c.misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+
+  template <typename Key, typename Value, typename Hash>
+  void
+  sharded_lru<Key, Value, Hash>::insert(const Key& key, const Value& value)
+  {
+    uint64_t h   = hash(key);
+    uint32_t tag = uint32_t(h >> 32) | 1;
+    shard&   sh  = shards[h & (shards.size() - 1)];
+    set&     s   = sh.sets[(h >> shard_bits) & (sets_per_shard - 1)];
+    record   r   = { key, value };
+
+    std::lock_guard<std::mutex> guard(sh.lock);
+
+    // inserted by another thread meanwhile: update
+    record old;
+    for (std::size_t w = 0; w < WAYS; w++)
+      if (s.tags[w].load(std::memory_order_relaxed) == tag &&
+          read(s.ways[w], old) && old.key == key)
+      {
+        write(s, w, tag, r);
+        return;
+      }
+
+    // a free entry, or the first one not referenced since the hand passed
+    std::size_t victim = WAYS;
+    for (std::size_t w = 0; w < WAYS && victim == WAYS; w++)
+      if (!s.tags[w].load(std::memory_order_relaxed))
+        victim = w;
+    while (victim == WAYS)
+    {
+      entry& e = s.ways[s.hand];
+      if (e.referenced.load(std::memory_order_relaxed))
+        e.referenced.store(0, std::memory_order_relaxed);
+      else
+      {
+        victim = s.hand;
+        sh.evictions++;
+      }
+      s.hand = (s.hand + 1) % WAYS;
+    }
+
+    s.ways[victim].referenced.store(0, std::memory_order_relaxed);
+    write(s, victim, tag, r);
+  }
+
+
+  template <typename Key, typename Value, typename Hash>
+  typename sharded_lru<Key, Value, Hash>::statistics
+  sharded_lru<Key, Value, Hash>::stats() const
+  {
+    statistics st = { 0, 0, 0 };
+    for (std::size_t i = 0; i < NB_STRIPES; i++)
+    {
+      st.hits   += stripes[i].hits.load(std::memory_order_relaxed);
+      st.misses += stripes[i].misses.load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < shards.size(); i++)
+    {
+      std::lock_guard<std::mutex> guard(shards[i].lock);
+      st.evictions += shards[i].evictions;
+    }
+    return st;
+  }
+
+
+  template <typename Key, typename Value, typename Hash>
+  void
+  sharded_lru<Key, Value, Hash>::clear()
+  {
+    record none;
+    std::memset(&none, 0, sizeof(record));
+    for (std::size_t i = 0; i < shards.size(); i++)
+    {
+      shard& sh = shards[i];
+      std::lock_guard<std::mutex> guard(sh.lock);
+      for (std::size_t j = 0; j < sh.sets.size(); j++)
+      {
+        set& s = sh.sets[j];
+        s.hand = 0;
+        for (std::size_t w = 0; w < WAYS; w++)
+        {
+          s.ways[w].referenced.store(0, std::memory_order_relaxed);
+          write(s, w, 0, none);
+        }
+      }
+    }
+  }
+
+} // end of namespace wnb
+
+#endif /* _SHARDED_LRU_HH */
@@ -0,0 +1,624 @@
+#include "snapshot.hh"
+
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+#include <stdint.h>
+
+#include "wordnet.hh"
+#include "info_helper.hh"
+#include "mapped_file.hh"
+
+namespace wnb
+{
+  namespace snapshot
+  {
+
+    namespace
+    {
+      const char MAGIC[8] = { 'W', 'N', 'B', 'S', 'N', 'A', 'P', '\0' };
+      const uint32_t ENDIAN_MARK = 0x01020304;
+
+      enum section_id
+      {
+        STRINGS = 0,
+        SYNSETS,
+        WORDS,
+        TAGS,
+        EDGES,
+        INDEXES,
+        INDEX_PTRS,
+        INDEX_OFFSETS,
+        EXCEPTIONS,
+        EXCEPTION_ALTS,
+        POS_OFFSETS,
+        NB_SECTIONS
+      };
+
+      // On-disk records
+      //------------------------------------------------
+
+      struct str_ref
+      {
+        uint32_t off;
+        uint32_t len;
+      };
+
+      struct range
+      {
+        uint32_t begin;
+        uint32_t count;
+      };
+
+      struct synset_rec
+      {
+        int32_t  lex_filenum;
+        uint32_t w_cnt;
+        uint32_t p_cnt;
+        int32_t  pos;
+        int32_t  id;
+        int32_t  sense_number;
+        str_ref  gloss;
+        range    words;
+        range    tags;
+        range    edges;
+      };
+
+      struct word_rec
+      {
+        str_ref word;
+        int32_t lex_id;
+      };
+
+      struct tag_rec
+      {
+        str_ref word;
+        int32_t cnt;
+      };
+
+      struct edge_rec
+      {
+        uint32_t target_vertex;
+        int32_t  pointer_symbol;
+        int32_t  source;
+        int32_t  target;
+      };
+
+      struct index_rec
+      {
+        str_ref  lemma;
+        uint32_t synset_cnt;
+        uint32_t p_cnt;
+        uint32_t sense_cnt;
+        float    tagsense_cnt;
+        int32_t  pos;
+        range    ptr_symbols;
+        range    synsets;
+      };
+
+      struct index_offset_rec
+      {
+        int32_t offset;
+        int32_t id;
+      };
+
+      struct exc_rec
+      {
+        int32_t pos;
+        str_ref key;
+        range   alts;
+      };
+
+      struct pos_offset_rec
+      {
+        int32_t pos;
+        int32_t offset;
+        int32_t indice;
+      };
+
+      struct section_entry
+      {
+        uint32_t id;
+        uint32_t record_size;
+        uint64_t offset;
+        uint64_t count;
+      };
+
+      struct header
+      {
+        char          magic[8];
+        uint32_t      version;
+        uint32_t      endian_mark;
+        uint64_t      file_size;
+        uint64_t      checksum;   ///< of everything following the header
+        uint32_t      nb_sections;
+        uint32_t      pad;
+        section_entry sections[NB_SECTIONS];
+      };
+
+      /// Cheap 64 bit hash of a buffer, word at a time
+      uint64_t checksum(const char* b, const char* e)
+      {
+        uint64_t h = 14695981039346656037ULL;
+        for (; e - b >= 8; b += 8)
+        {
+          uint64_t w;
+          std::memcpy(&w, b, 8);
+          h = (h ^ w) * 1099511628211ULL;
+          h ^= h >> 29;
+        }
+        for (; b != e; ++b)
+          h = (h ^ (unsigned char)*b) * 1099511628211ULL;
+        return h;
+      }
+
+      // Writing
+      //------------------------------------------------
+
+      class string_pool
+      {
+      public:
+        str_ref add(string_ref ref)
+        {
+          std::string s = ref.to_string();
+          std::unordered_map<std::string, str_ref>::iterator it = _refs.find(s);
+          if (it != _refs.end())
+            return it->second;
+          str_ref r = { (uint32_t)_pool.size(), (uint32_t)s.size() };
+          _pool.insert(_pool.end(), s.begin(), s.end());
+          _refs.insert(std::make_pair(s, r));
+          return r;
+        }
+
+        const std::vector<char>& data() const { return _pool; }
+
+      private:
+        std::vector<char>                        _pool;
+        std::unordered_map<std::string, str_ref> _refs;
+      };
+
+      inline range make_range(std::size_t begin, std::size_t end)
+      {
+        range r = { (uint32_t)begin, (uint32_t)(end - begin) };
+        return r;
+      }
+
+      class writer
+      {
+      public:
+        writer() : _payload(), _header()
+        {
+          std::memset(&_header, 0, sizeof(_header));
+        }
+
+        template <typename T>
+        void add(section_id id, const std::vector<T>& v)
+        {
+          // keep every section 8 bytes aligned (from the file start)
+          while ((sizeof(header) + _payload.size()) % 8)
+            _payload.push_back(0);
+
+          section_entry& s = _header.sections[id];
+          s.id          = id;
+          s.record_size = sizeof(T);
+          s.offset      = sizeof(header) + _payload.size();
+          s.count       = v.size();
+
+          const char* b = reinterpret_cast<const char*>(v.data());
+          _payload.insert(_payload.end(), b, b + v.size() * sizeof(T));
+        }
+
+        void write(const std::string& fn)
+        {
+          std::memcpy(_header.magic, MAGIC, sizeof(MAGIC));
+          _header.version     = VERSION;
+          _header.endian_mark = ENDIAN_MARK;
+          _header.file_size   = sizeof(header) + _payload.size();
+          _header.checksum    = checksum(_payload.data(),
+                                         _payload.data() + _payload.size());
+          _header.nb_sections = NB_SECTIONS;
+
+          std::ofstream fout(fn.c_str(), std::ios::binary | std::ios::trunc);
+          if (!fout.is_open())
+            throw std::runtime_error("Cannot write snapshot: " + fn);
+          fout.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+          fout.write(_payload.data(), _payload.size());
+          if (!fout)
+            throw std::runtime_error("Cannot write snapshot: " + fn);
+        }
+
+      private:
+        std::vector<char> _payload;
+        header            _header;
+      };
+
+      // Reading
+      //------------------------------------------------
+
+      template <typename T>
+      struct section
+      {
+        const T*    data;
+        std::size_t count;
+      };
+
+      class reader
+      {
+      public:
+        reader(const std::string& fn)
+          : _fn(fn), _file(fn)
+        {
+          if (_file.size() < sizeof(header))
+            fail("file too small");
+
+          std::memcpy(&_header, _file.begin(), sizeof(header));
+          if (std::memcmp(_header.magic, MAGIC, sizeof(MAGIC)))
+            fail("not a wnb snapshot");
+          if (_header.endian_mark != ENDIAN_MARK)
+            fail("endianness mismatch");
+          if (_header.version != VERSION)
+            fail("unsupported version");
+          if (_header.file_size != _file.size())
+            fail("truncated file");
+          if (_header.nb_sections != NB_SECTIONS)
+            fail("bad section table");
+          if (_header.checksum != checksum(_file.begin() + sizeof(header),
+                                           _file.end()))
+            fail("checksum mismatch");
+        }
+
+        template <typename T>
+        section<T> get(section_id id)
+        {
+          const section_entry& s = _header.sections[id];
+          if (s.id != (uint32_t)id || s.record_size != sizeof(T)
+              || s.offset % 8 || s.offset > _file.size()
+              || s.count > (_file.size() - s.offset) / sizeof(T))
+            fail("bad section");
+
+          section<T> sec;
+          sec.data  = reinterpret_cast<const T*>(_file.begin() + s.offset);
+          sec.count = s.count;
+          return sec;
+        }
+
+        void fail(const std::string& why) const
+        {
+          throw std::runtime_error("Invalid snapshot " + _fn + ": " + why);
+        }
+
+      private:
+        std::string _fn;
+        mapped_file _file;
+        header      _header;
+      };
+
+      template <typename T>
+      void check_range(const range& r, const section<T>& s, const reader& in)
+      {
+        if (r.begin > s.count || r.count > s.count - r.begin)
+          in.fail("bad range");
+      }
+
+      /// String r of the string pool, referring to the copy held by an arena
+      string_ref get_ref(const list_ref<char>& chars, const str_ref& r,
+                         const reader& in)
+      {
+        if (r.off > chars.size() || r.len > chars.size() - r.off)
+          in.fail("bad string reference");
+        return string_ref(chars.begin() + r.off, r.len);
+      }
+
+      // Ranges may overlap in a damaged file, check before filling p
+      template <typename T>
+      void check_room(const pool<T>& p, std::size_t n, const reader& in)
+      {
+        if (n > p.capacity() - p.size())
+          in.fail("overlapping ranges");
+      }
+
+      pos_t get_pos(int32_t pos, const reader& in)
+      {
+        if (pos < 0 || pos >= (int32_t)POS_ARRAY_SIZE)
+          in.fail("bad pos");
+        return (pos_t)pos;
+      }
+
+    } // end of anonymous namespace
+
+
+    void save(const wordnet& wn, const std::string& fn)
+    {
+      string_pool                   strings;
+      std::vector<synset_rec>       synsets;
+      std::vector<word_rec>         words;
+      std::vector<tag_rec>          tags;
+      std::vector<edge_rec>         edges;
+      std::vector<index_rec>        indexes;
+      std::vector<str_ref>          index_ptrs;
+      std::vector<index_offset_rec> index_offsets;
+      std::vector<exc_rec>          exceptions;
+      std::vector<str_ref>          exception_alts;
+      std::vector<pos_offset_rec>   pos_offsets;
+
+      // graph
+      const wordnet::graph& g = wn.wordnet_graph;
+      std::size_t nb_vertices = boost::num_vertices(g);
+      for (std::size_t u = 0; u < nb_vertices; u++)
+      {
+        const synset& s = g[u];
+        synset_rec rec;
+        rec.lex_filenum  = s.lex_filenum;
+        rec.w_cnt        = s.w_cnt;
+        rec.p_cnt        = s.p_cnt;
+        rec.pos          = s.pos;
+        rec.id           = s.id;
+        rec.sense_number = s.sense_number;
+        rec.gloss        = strings.add(wn.gloss(s));
+
+        std::size_t begin = words.size();
+        for (std::size_t i = 0; i < s.words.size(); i++)
+        {
+          word_rec w = { strings.add(s.words[i]),
+                         (i < s.lex_ids.size()) ? s.lex_ids[i] : 0 };
+          words.push_back(w);
+        }
+        rec.words = make_range(begin, words.size());
+
+        begin = tags.size();
+        for (std::size_t i = 0; i < s.tag_cnts.size(); i++)
+        {
+          tag_rec t = { strings.add(s.tag_cnts[i].first), s.tag_cnts[i].second };
+          tags.push_back(t);
+        }
+        rec.tags = make_range(begin, tags.size());
+
+        begin = edges.size();
+        boost::graph_traits<wordnet::graph>::out_edge_iterator e, e_end;
+        for (boost::tie(e, e_end) = boost::out_edges((unsigned)u, g); e != e_end; ++e)
+        {
+          const ptr& p = g[*e];
+          edge_rec r = { (uint32_t)boost::target(*e, g),
+                         p.pointer_symbol, p.source, p.target };
+          edges.push_back(r);
+        }
+        rec.edges = make_range(begin, edges.size());
+
+        synsets.push_back(rec);
+      }
+
+      // index
+      for (std::size_t k = 0; k < wn.index_list.size(); k++)
+      {
+        const index& idx = wn.index_list[k];
+        index_rec rec;
+        rec.lemma        = strings.add(idx.lemma);
+        rec.synset_cnt   = idx.synset_cnt;
+        rec.p_cnt        = idx.p_cnt;
+        rec.sense_cnt    = idx.sense_cnt;
+        rec.tagsense_cnt = idx.tagsense_cnt;
+        rec.pos          = idx.pos;
+
+        std::size_t begin = index_ptrs.size();
+        for (std::size_t i = 0; i < idx.ptr_symbols.size(); i++)
+          index_ptrs.push_back(strings.add(idx.ptr_symbols[i]));
+        rec.ptr_symbols = make_range(begin, index_ptrs.size());
+
+        begin = index_offsets.size();
+        for (std::size_t i = 0; i < idx.synset_offsets.size(); i++)
+        {
+          index_offset_rec o = { idx.synset_offsets[i], idx.synset_ids[i] };
+          index_offsets.push_back(o);
+        }
+        rec.synsets = make_range(begin, index_offsets.size());
+
+        indexes.push_back(rec);
+      }
+
+      // exceptions
+      for (std::size_t k = 0; k < wn.exc.size(); k++)
+      {
+        exc_rec rec;
+        rec.pos = wn.exc.pos(k);
+        rec.key = strings.add(wn.exc.form(k));
+        list_ref<string_ref> alts = wn.exc.base_forms(k);
+        std::size_t begin = exception_alts.size();
+        for (std::size_t i = 0; i < alts.size(); i++)
+          exception_alts.push_back(strings.add(alts[i]));
+        rec.alts = make_range(begin, exception_alts.size());
+        exceptions.push_back(rec);
+      }
+
+      // offset -> indice maps
+      for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+        for (std::size_t i = 0; i < wn.info.pos_offsets[p].size(); i++)
+        {
+          pos_offset_rec rec = { (int32_t)p, wn.info.pos_offsets[p][i], (int32_t)i };
+          pos_offsets.push_back(rec);
+        }
+
+      writer out;
+      out.add(STRINGS,        strings.data());
+      out.add(SYNSETS,        synsets);
+      out.add(WORDS,          words);
+      out.add(TAGS,           tags);
+      out.add(EDGES,          edges);
+      out.add(INDEXES,        indexes);
+      out.add(INDEX_PTRS,     index_ptrs);
+      out.add(INDEX_OFFSETS,  index_offsets);
+      out.add(EXCEPTIONS,     exceptions);
+      out.add(EXCEPTION_ALTS, exception_alts);
+      out.add(POS_OFFSETS,    pos_offsets);
+      out.write(fn);
+    }
+
+
+    void load(const std::string& fn, wordnet& wn)
+    {
+      reader in(fn);
+
+      section<char>             strings        = in.get<char>(STRINGS);
+      section<synset_rec>       synsets        = in.get<synset_rec>(SYNSETS);
+      section<word_rec>         words          = in.get<word_rec>(WORDS);
+      section<tag_rec>          tags           = in.get<tag_rec>(TAGS);
+      section<edge_rec>         edges          = in.get<edge_rec>(EDGES);
+      section<index_rec>        indexes        = in.get<index_rec>(INDEXES);
+      section<str_ref>          index_ptrs     = in.get<str_ref>(INDEX_PTRS);
+      section<index_offset_rec> index_offsets  = in.get<index_offset_rec>(INDEX_OFFSETS);
+      section<exc_rec>          exceptions     = in.get<exc_rec>(EXCEPTIONS);
+      section<str_ref>          exception_alts = in.get<str_ref>(EXCEPTION_ALTS);
+      section<pos_offset_rec>   pos_offsets    = in.get<pos_offset_rec>(POS_OFFSETS);
+
+      // offset -> indice maps
+      std::vector<info_helper::offsets_t> offsets(POS_ARRAY_SIZE);
+      for (std::size_t i = 0; i < pos_offsets.count; i++)
+      {
+        const pos_offset_rec& r = pos_offsets.data[i];
+        info_helper::offsets_t& v = offsets[get_pos(r.pos, in)];
+        if (r.indice != (int32_t)v.size())
+          in.fail("bad offset table");
+        v.push_back(r.offset);
+      }
+      wn.info = info_helper();
+      try
+      {
+        for (std::size_t p = N; p < POS_ARRAY_SIZE; p++)
+          wn.info.set_offsets((pos_t)p, offsets[p]);
+      }
+      catch (std::runtime_error&)
+      {
+        in.fail("bad offset table");
+      }
+
+      // arena: the string pool is copied as is
+      arena& storage = wn.storage;
+      storage.chars.reset(strings.count);
+      storage.strings.reset(words.count + index_ptrs.count);
+      storage.ints.reset(words.count + 2 * index_offsets.count);
+      storage.tags.reset(tags.count);
+      list_ref<char> chars = storage.chars.append(strings.data,
+                                                  strings.data + strings.count);
+
+      // graph
+      // graph: edges first, the graph is immutable once built
+      std::vector<graph_edge> graph_edges;
+      graph_edges.reserve(edges.count);
+      for (std::size_t u = 0; u < synsets.count; u++)
+      {
+        const range& r = synsets.data[u].edges;
+        check_range(r, edges, in);
+        for (uint32_t i = 0; i < r.count; i++)
+        {
+          const edge_rec& e = edges.data[r.begin + i];
+          if (e.target_vertex >= synsets.count)
+            in.fail("bad edge");
+          graph_edge ge = { (unsigned)u, e.target_vertex,
+                            { e.pointer_symbol, e.source, e.target } };
+          graph_edges.push_back(ge);
+        }
+      }
+      wn.build_graph(synsets.count, graph_edges);
+
+      for (std::size_t u = 0; u < synsets.count; u++)
+      {
+        const synset_rec& rec = synsets.data[u];
+        synset& s = wn.wordnet_graph[u];
+        s.lex_filenum  = rec.lex_filenum;
+        s.w_cnt        = rec.w_cnt;
+        s.p_cnt        = rec.p_cnt;
+        s.pos          = get_pos(rec.pos, in);
+        if (rec.id != (int32_t)u) // synset ids are graph vertices
+          in.fail("bad synset id");
+        s.id           = rec.id;
+        s.sense_number = rec.sense_number;
+        s.gloss        = get_ref(chars, rec.gloss, in);
+
+        check_range(rec.words, words, in);
+        check_room(storage.strings, rec.words.count, in);
+        check_room(storage.ints, rec.words.count, in);
+        std::size_t first = storage.strings.size();
+        for (uint32_t i = 0; i < rec.words.count; i++)
+          storage.strings.push_back(get_ref(chars, words.data[rec.words.begin + i].word, in));
+        s.words = storage.strings.range(first, storage.strings.size());
+        first = storage.ints.size();
+        for (uint32_t i = 0; i < rec.words.count; i++)
+          storage.ints.push_back(words.data[rec.words.begin + i].lex_id);
+        s.lex_ids = storage.ints.range(first, storage.ints.size());
+
+        check_range(rec.tags, tags, in);
+        check_room(storage.tags, rec.tags.count, in);
+        first = storage.tags.size();
+        for (uint32_t i = 0; i < rec.tags.count; i++)
+        {
+          const tag_rec& t = tags.data[rec.tags.begin + i];
+          storage.tags.push_back(std::make_pair(get_ref(chars, t.word, in), (int)t.cnt));
+        }
+        s.tag_cnts = storage.tags.range(first, storage.tags.size());
+      }
+
+      // index (sorted by lemma when saved, entries of a lemma in load
+      // order, each pos once; checked: lookups rely on it)
+      wn.index_list.clear();
+      wn.index_list.resize(indexes.count);
+      unsigned lemma_pos = 0; ///< bit p: pos p seen for the current lemma
+      for (std::size_t k = 0; k < indexes.count; k++)
+      {
+        const index_rec& rec = indexes.data[k];
+        index& idx = wn.index_list[k];
+        idx.lemma        = get_ref(chars, rec.lemma, in);
+        idx.synset_cnt   = rec.synset_cnt;
+        idx.p_cnt        = rec.p_cnt;
+        idx.sense_cnt    = rec.sense_cnt;
+        idx.tagsense_cnt = rec.tagsense_cnt;
+        idx.pos          = get_pos(rec.pos, in);
+        int c = (k > 0) ? wn.index_list[k - 1].lemma.compare(idx.lemma) : -1;
+        if (c > 0 || (c == 0 && (lemma_pos & (1u << idx.pos))))
+          in.fail("unsorted index");
+        lemma_pos = ((c == 0) ? lemma_pos : 0) | (1u << idx.pos);
+
+        check_range(rec.ptr_symbols, index_ptrs, in);
+        check_room(storage.strings, rec.ptr_symbols.count, in);
+        std::size_t first = storage.strings.size();
+        for (uint32_t i = 0; i < rec.ptr_symbols.count; i++)
+          storage.strings.push_back(
+            get_ref(chars, index_ptrs.data[rec.ptr_symbols.begin + i], in));
+        idx.ptr_symbols = storage.strings.range(first, storage.strings.size());
+
+        check_range(rec.synsets, index_offsets, in);
+        check_room(storage.ints, 2 * (std::size_t)rec.synsets.count, in);
+        const index_offset_rec* o = index_offsets.data + rec.synsets.begin;
+        first = storage.ints.size();
+        for (uint32_t i = 0; i < rec.synsets.count; i++)
+          storage.ints.push_back(o[i].offset);
+        idx.synset_offsets = storage.ints.range(first, storage.ints.size());
+        first = storage.ints.size();
+        for (uint32_t i = 0; i < rec.synsets.count; i++)
+        {
+          if (o[i].id < 0 || (uint32_t)o[i].id >= synsets.count)
+            in.fail("bad index synset");
+          storage.ints.push_back(o[i].id);
+        }
+        idx.synset_ids = storage.ints.range(first, storage.ints.size());
+      }
+
+      // exceptions
+      wn.exc.clear();
+      for (std::size_t k = 0; k < exceptions.count; k++)
+      {
+        const exc_rec& rec = exceptions.data[k];
+        pos_t      pos  = get_pos(rec.pos, in);
+        string_ref form = get_ref(chars, rec.key, in);
+        check_range(rec.alts, exception_alts, in);
+        for (uint32_t i = 0; i < rec.alts.count; i++)
+          wn.exc.add(pos, form, get_ref(chars, exception_alts.data[rec.alts.begin + i], in));
+      }
+      wn.exc.build();
+    }
+
+  } // end of namespace wnb::snapshot
+
+} // end of namespace wnb
@@ -0,0 +1,36 @@
+#ifndef _SNAPSHOT_HH
+# define _SNAPSHOT_HH
+
+# include <string>
+
+namespace wnb
+{
+  /// forward declaration
+  struct wordnet;
+
+  /// Binary snapshot of a loaded wordnet (graph, index, exceptions, senses)
+  ///
+  /// The file is a header, a section table and flat arrays of fixed-size
+  /// records. Strings live in a single pool and are referenced by
+  /// (offset, length); lists are (begin, count) ranges into other sections.
+  /// Nothing is pointer-based. Loading checks the file, then copies the
+  /// records into the wordnet and rebuilds its graph: no text parsing,
+  /// but the loaded wordnet does not use the file in place.
+  namespace snapshot
+  {
+    /// Bump whenever the layout of any record changes
+    /// (2: exceptions in exception_table order, one record per form)
+    static const unsigned VERSION = 2;
+
+    /// Write \p wn to \p fn
+    void save(const wordnet& wn, const std::string& fn);
+
+    /// Fill an empty \p wn from \p fn
+    /// Throw std::runtime_error if the file is not a valid snapshot of the
+    /// current version (bad magic, version, endianness, size or checksum).
+    void load(const std::string& fn, wordnet& wn);
+  }
+
+} // end of namespace wnb
+
+#endif /* _SNAPSHOT_HH */
@@ -1,4 +1,6 @@
 #include <wnb/core/wordnet.hh>
+#include <wnb/core/snapshot.hh>
+#include <wnb/core/scanner.hh>
 #include <wnb/std_ext.hh>
 
 #include <string>
@@ -13,17 +15,30 @@ namespace wnb
 
   //FIXME: Make (smart) use of fs::path
   wordnet::wordnet(const std::string& wordnet_dir, bool verbose)
-    : _verbose(verbose)
+    : _verbose(verbose), _morph_cache_capacity(0)
+  {
+    load_options options;
+    options.verbose = verbose;
+    load(wordnet_dir, options);
+  }
+
+  wordnet::wordnet(const std::string& wordnet_dir, const load_options& options)
+    : _verbose(options.verbose), _morph_cache_capacity(0)
+  {
+    load(wordnet_dir, options);
+  }
+
+  void
+  wordnet::load(const std::string& wordnet_dir, const load_options& options)
   {
     if (_verbose)
     {
       std::cout << wordnet_dir << std::endl;
     }
 
-    info = preprocess_wordnet(wordnet_dir);
-
-    wordnet_graph = graph(info.nb_synsets());
-    load_wordnet(wordnet_dir, *this, info);
+    load_wordnet(wordnet_dir, *this, info, options);
+    lemmas.build(index_list);
+    compile_morphology();
 
     if (_verbose)
     {
@@ -33,47 +48,189 @@ namespace wnb
     assert(info.nb_synsets() == 142335);//117659);
   }
 
+  wordnet::wordnet(from_snapshot_t, const std::string& snapshot_file, bool verbose)
+    : _verbose(verbose), _morph_cache_capacity(0)
+  {
+    if (_verbose)
+    {
+      std::cout << snapshot_file << std::endl;
+    }
+
+    snapshot::load(snapshot_file, *this);
+    lemmas.build(index_list);
+    compile_morphology();
+
+    if (_verbose)
+    {
+      std::cout << "nb_synsets: " << info.nb_synsets() << std::endl;
+    }
+  }
+
+  wordnet::wordnet(const wordnet& other)
+    : _verbose(other._verbose), _morph_cache_capacity(0)
+  {
+    *this = other;
+  }
+
+  wordnet&
+  wordnet::operator=(const wordnet& other)
+  {
+    if (this == &other)
+      return *this;
+
+    morphologicalrules = other.morphologicalrules;
+    index_list         = other.index_list;
+    lemmas             = other.lemmas;
+    for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+    {
+      morph_tries[p] = other.morph_tries[p];
+      gloss_files[p] = other.gloss_files[p];
+    }
+    morph_by_rule      = other.morph_by_rule;
+    morph_all          = other.morph_all;
+    morph_all_pos      = other.morph_all_pos;
+    wordnet_graph      = other.wordnet_graph;
+    info               = other.info;
+    storage            = other.storage;
+    _verbose           = other._verbose;
+    exc                = other.exc;
+    set_morph_cache(other._morph_cache_capacity);
+
+    // refer to the copy of the arena
+    for (std::size_t u = 0; u < num_vertices(wordnet_graph); u++)
+    {
+      synset& s  = wordnet_graph[u];
+      s.words    = storage.rebase(s.words, other.storage);
+      s.lex_ids  = storage.rebase(s.lex_ids, other.storage);
+      s.gloss    = storage.rebase(s.gloss, other.storage);
+      s.tag_cnts = storage.rebase(s.tag_cnts, other.storage);
+    }
+    for (std::size_t i = 0; i < index_list.size(); i++)
+    {
+      index& idx         = index_list[i];
+      idx.lemma          = storage.rebase(idx.lemma, other.storage);
+      idx.ptr_symbols    = storage.rebase(idx.ptr_symbols, other.storage);
+      idx.synset_offsets = storage.rebase(idx.synset_offsets, other.storage);
+      idx.synset_ids     = storage.rebase(idx.synset_ids, other.storage);
+    }
+    return *this;
+  }
+
+  void
+  wordnet::save_snapshot(const std::string& fn) const
+  {
+    snapshot::save(*this, fn);
+  }
+
+  namespace
+  {
+    bool edge_less(const graph_edge& a, const graph_edge& b)
+    {
+      if (a.u != b.u)
+        return a.u < b.u;
+      return a.p.pointer_symbol < b.p.pointer_symbol;
+    }
+  }
+
+  void
+  wordnet::build_graph(std::size_t nb_synsets, std::vector<graph_edge>& edges)
+  {
+    std::stable_sort(edges.begin(), edges.end(), edge_less);
+
+    std::vector<std::pair<unsigned, unsigned> > uv(edges.size());
+    std::vector<ptr>                            props(edges.size());
+    for (std::size_t i = 0; i < edges.size(); i++)
+    {
+      uv[i]    = std::make_pair(edges[i].u, edges[i].v);
+      props[i] = edges[i].p;
+    }
+
+    wordnet_graph = graph(boost::edges_are_sorted, uv.begin(), uv.end(),
+                          props.begin(), nb_synsets);
+  }
+
+  string_ref
+  wordnet::gloss(const synset& s) const
+  {
+    pos_t pos = (s.pos == S) ? A : s.pos;
+    const mapped_file& file = gloss_files[pos];
+    if (file.empty())
+      return s.gloss;
+
+    // The offset of a synset is the position of its line in data.<pos>
+    // (checked, in case the file changed since it was loaded)
+    std::size_t i = s.id - info.get_indice_offset(pos);
+    if (s.id < info.get_indice_offset(pos) || i >= info.pos_offsets[pos].size())
+      throw std::runtime_error("Bad synset id for gloss: " + std::to_string(s.id));
+    std::size_t offset = info.pos_offsets[pos][i];
+    int line_offset = -1;
+    scan::fields srow(file.begin() + std::min(offset, file.size()), file.end());
+    if (offset >= file.size() || !srow.dec(line_offset) ||
+        std::size_t(line_offset) != offset)
+      throw std::runtime_error("Bad gloss offset in " + file.path() + ": " +
+                               std::to_string(offset));
+
+    const char* b = 0;
+    const char* e = 0;
+    scan::lines lines(srow.cur, file.end());
+    if (!lines.next(b, e))
+      return string_ref();
+
+    // the gloss follows the '|' field (see load_data_row), none without it
+    srow = scan::fields(b, e);
+    while (srow.token(b, e))
+      if (e - b == 1 && *b == '|')
+        return string_ref(srow.cur, srow.end - srow.cur);
+    return string_ref();
+  }
+
   std::vector<synset>
   wordnet::get_synsets(const std::string& word, pos_t pos)
   {
+    std::vector<int> ids;
+    get_synset_ids(word, ids, pos);
+
     std::vector<synset> synsets;
+    synsets.reserve(ids.size());
+    for (std::size_t i = 0; i < ids.size(); i++)
+      synsets.push_back(wordnet_graph[ids[i]]);
+    return synsets;
+  }
 
+  void
+  wordnet::get_synset_ids(const std::string& word, std::vector<int>& ids, pos_t pos) const
+  {
     // morphing
     std::string mword = morphword(word, pos);
     if (mword == "")
-      return synsets;
+      return;
 
-    // binary_search
-    typedef std::vector<index> vi;
-    std::pair<vi::iterator,vi::iterator> bounds = get_indexes(mword);
+    get_lemma_synset_ids(string_ref(mword), ids, pos);
+  }
 
-    vi::iterator it;
-    for (it = bounds.first; it != bounds.second; it++)
-    {
+  void
+  wordnet::get_lemma_synset_ids(string_ref lemma, std::vector<int>& ids, pos_t pos) const
+  {
+    list_ref<index> indexes = find_indexes(lemma);
+    for (const index* it = indexes.begin(); it != indexes.end(); it++)
       if (pos == pos_t::UNKNOWN || it->pos == pos)
-      {
-        for (std::size_t i = 0; i < it->synset_ids.size(); i++)
-        {
-          int id = it->synset_ids[i];
-          synsets.push_back(wordnet_graph[id]);
-        }
-      }
-    }
-
-    return synsets;
+        ids.insert(ids.end(), it->synset_ids.begin(), it->synset_ids.end());
   }
 
   std::pair<std::vector<index>::iterator, std::vector<index>::iterator>
   wordnet::get_indexes(const std::string& word)
   {
-    index light_index;
-    light_index.lemma = word;
-
-    typedef std::vector<index> vi;
-    std::pair<vi::iterator,vi::iterator> bounds =
-      std::equal_range(index_list.begin(), index_list.end(), light_index);
+    lemma_table::range_t r = lemmas.find(string_ref(word), index_list);
+    return std::make_pair(index_list.begin() + r.first,
+                          index_list.begin() + r.second);
+  }
 
-    return bounds;
+  list_ref<index>
+  wordnet::find_indexes(string_ref word) const
+  {
+    lemma_table::range_t r = lemmas.find(word, index_list);
+    return list_ref<index>(index_list.data() + r.first,
+                           index_list.data() + r.second);
   }
 
   std::string
@@ -98,98 +255,453 @@ namespace wnb
     return true;
   }
 
-  // Try to find baseform (lemma) of individual word in POS
-  std::string
-  wordnet::morphword(const std::string& word, pos_t pos)
+  void
+  wordnet::compile_morphology()
   {
-    std::vector<std::string> results;
-
-    auto it = morphologicalrules.find( pos );
-    if( it != morphologicalrules.end() )
+    for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+      morph_tries[p].clear();
+    morph_by_rule = 0;
+    for (auto& rules : morphologicalrules)
+      if (morph_trie::compilable(rules.second))
+        morph_tries[rules.first].build(rules.second);
+      else
+        morph_by_rule |= 1u << rules.first;
+
+    // merge the rules of every pos, keeping the order of each pos (a rule
+    // is shared only if it comes after the previous rule of the pos)
+    morph_trie::rules_t all;
+    morph_all_pos.clear();
+    for (auto& rules : morphologicalrules)
     {
-      results = _morphword( word, pos );
+      std::size_t next = 0;
+      for (std::size_t i = 0; i < rules.second.size(); i++)
+      {
+        std::size_t j = std::find(all.begin() + next, all.end(), rules.second[i])
+                        - all.begin();
+        if (j == all.size())
+        {
+          all.push_back(rules.second[i]);
+          morph_all_pos.push_back(0);
+        }
+        morph_all_pos[j] |= 1u << rules.first;
+        next = j + 1;
+      }
     }
+
+    morph_all.clear();
+    if (!morph_by_rule && all.size() <= morph_trie::max_rules)
+      morph_all.build(all);
     else
+      morph_all_pos.clear(); // searched pos by pos
+  }
+
+  namespace
+  {
+
+    /// Set of pos (bit p: pos p)
+    typedef unsigned pos_mask;
+
+    /// Forms derived from a word by the rules of a trie, written in place
+    /// in buf (rules never lengthen a form). With rule_pos, the rules of
+    /// several pos: a form only goes with the pos of all the rules applied.
+    struct morph_walk
     {
-      for( auto &pos : morphologicalrules )
-        if( pos.first != pos_t::S )     // revisit, probably filter if
+      const morph_trie& trie;
+      const unsigned*   rule_pos; ///< pos of each rule, 0: a single pos
+      char*             buf;
+      pos_mask          live;     ///< pos still searched
+      pos_mask          reached;  ///< pos having forms at the searched depth
+
+      /// Visit the forms derived from buf[0, len) by exactly depth rules of
+      /// the pos of mask, in the order of _morphword (rules in order at
+      /// each level), calling visit(form, pos) until it returns true (then
+      /// return true)
+      template <typename Visit>
+      bool forms(std::size_t len, unsigned depth, pos_mask mask, Visit& visit)
+      {
+        if (depth == 0)
         {
-          std::vector<std::string> temp = _morphword( word, pos.first ); // gotta be a better way than this
-          results.insert( results.end(), temp.begin(), temp.end() );
+          reached |= mask;
+          return visit(string_ref(buf, len), mask);
         }
-    }
 
-    if( results.empty() ) return "";
-
-    //cout << "results: ";
-    //for( auto r : results ) cout << r << ", "; cout << endl;
+        uint64_t rules = trie.match(buf, buf + len);
+        for (std::size_t i = 0; rules != 0; i++, rules >>= 1)
+        {
+          pos_mask m = mask & live;
+          if (rule_pos)
+            m &= rule_pos[i];
+          if (!(rules & 1) || !m)
+            continue;
+          const std::string& suffix   = trie.suffix(i);
+          const std::string& addition = trie.addition(i);
+          std::size_t stem = len - suffix.size();
+
+          std::copy(addition.begin(), addition.end(), buf + stem);
+          bool stop = forms(stem + addition.size(), depth - 1, m, visit);
+          // the addition overwrote the start of the suffix
+          std::copy(suffix.begin(), suffix.begin() + addition.size(), buf + stem);
+          if (stop)
+            return true;
+        }
+        return false;
+      }
+    };
 
-    return *(results.begin());
-  }
+    /// Same as morph_walk over rules that are not compiled, applied one by
+    /// one as _morphword did (each form is a copy, forms may grow)
+    struct rule_walk
+    {
+      const morph_trie::rules_t& rules;
+      pos_mask                   reached;
 
-  std::vector<std::string> 
-  wordnet::_morphword(const std::string &form, pos_t pos)
-  {
-    std::vector<std::pair<std::string,std::string> > &morphsubs = morphologicalrules[pos];
-    std::vector<std::string> results;
+      template <typename Visit>
+      bool forms(const std::string& form, unsigned depth, Visit& visit)
+      {
+        if (depth == 0)
+        {
+          reached = 1;
+          return visit(string_ref(form), 1);
+        }
 
-    auto copyfilter = [this,pos]( const std::string &s ) 
-          { 
-            auto indexes = this->get_indexes( s );
-            for( auto it=indexes.first; it!=indexes.second; ++it )
-              if( it->pos == pos )
-                return true;
+        for (std::size_t i = 0; i < rules.size(); i++)
+        {
+          const std::string& suffix = rules[i].first;
+          if (form.size() > suffix.size()
+              && form.compare(form.size() - suffix.size(), suffix.size(), suffix) == 0
+              && forms(form.substr(0, form.size() - suffix.size()) + rules[i].second,
+                       depth - 1, visit))
+            return true;
+        }
+        return false;
+      }
+    };
+
+    /// Base forms of form in pos (lemmas of pos), in the order of
+    /// _morphword: calls found(base) on the bases of the first group
+    /// having some (the exceptions of form if any, else form and the forms
+    /// one rule away, else the forms two rules away...) until it returns
+    /// true. Bases are the lemmas of the index (views of the arena).
+    /// Nothing is allocated for words of less than 64 characters.
+    template <typename Found>
+    void visit_base_forms(const wordnet& wn, string_ref form, pos_t pos,
+                          Found found)
+    {
+      // entry of s in pos, 0 if none
+      auto defined = [&wn, pos](string_ref s) -> const index*
+        {
+          list_ref<index> indexes = wn.find_indexes(s);
+          for (const index* it = indexes.begin(); it != indexes.end(); it++)
+            if (it->pos == pos)
+              return it;
+          return 0;
+        };
+
+      // check the exceptions list
+      list_ref<string_ref> exceptions = wn.exc.find(pos, form);
+      if (!exceptions.empty())
+      {
+        for (std::size_t i = 0; i < exceptions.size(); i++)
+        {
+          const index* entry = defined(exceptions[i]);
+          if (entry && found(entry->lemma))
+            return;
+        }
+        return;
+      }
 
+      bool any = false;
+      auto visit = [&](string_ref s, pos_mask)
+        {
+          const index* entry = defined(s);
+          if (!entry)
             return false;
-          };
+          any = true;
+          return found(entry->lemma);
+        };
 
-    // check the exceptions list
-    std::map<std::string,std::vector<std::string> > &exceptions = exc[pos];
-    std::map<std::string,std::vector<std::string> >::iterator except = exceptions.find( form  );
-    if( except != exceptions.end() )
-    {
-      results.resize( except->second.size() );
-      results.erase( copy_if( except->second.begin(), except->second.end(), results.begin(), copyfilter ), results.end() );
+      if (wn.morph_by_rule & (1u << pos))
+      {
+        rule_walk walk = { wn.morphologicalrules.at(pos), 0 };
+        std::string word = form.to_string();
+        for (unsigned depth = 0; ; depth++)
+        {
+          walk.reached = 0;
+          if (walk.forms(word, depth, visit))
+            return;
+          if (depth == 0) // form goes with the forms one rule away
+            continue;
+          if (any || !walk.reached)
+            return;
+        }
+      }
+
+      // apply the rules, depth by depth
+      char        small[64];
+      std::string large;
+      char*       buf = small;
+      if (form.size() > sizeof(small))
+      {
+        large.assign(form.begin(), form.end());
+        buf = &large[0];
+      }
+      else
+        std::copy(form.begin(), form.end(), buf);
 
-      return results;
+      morph_walk walk = { wn.morph_tries[pos], 0, buf, 1, 0 };
+      for (unsigned depth = 0; ; depth++)
+      {
+        walk.reached = 0;
+        if (walk.forms(form.size(), depth, 1, visit))
+          return;
+        if (depth == 0) // form goes with the forms one rule away
+          continue;
+        if (any || !walk.reached)
+          return;
+      }
     }
 
-    // apply the modify rules
-    std::vector<std::string> forms { form }, rules;
-    do
+    /// Pos searched when morphing for UNKNOWN, in order: those having
+    /// rules but satellites (revisit, probably filter if)
+    pos_mask unknown_pos_mask(const std::map< pos_t, morph_trie::rules_t >& rules)
     {
-      rules.clear();
-      for( std::string &f : forms )
+      pos_mask m = 0;
+      for (auto& r : rules)
+        if (r.first != pos_t::S)
+          m |= 1u << r.first;
+      return m;
+    }
+
+    /// First base form (as visit_base_forms) of form in each pos of wanted,
+    /// searched in all of them at once: bases[p] (empty if none). Each
+    /// candidate is looked up once for every pos it goes with. With
+    /// first_pos, stop as soon as the first pos of wanted having a base
+    /// form is known (other bases may be missing).
+    void all_base_forms(const wordnet& wn, string_ref form,
+                        pos_mask wanted, bool first_pos, string_ref* bases)
+    {
+      if (wn.morph_all_pos.empty()) // rules not merged, pos by pos
       {
-        for( std::pair<std::string,std::string> &sub : morphsubs )
+        for (std::size_t p = 1; p < POS_ARRAY_SIZE; p++)
         {
-          if( f.length() > sub.first.length() &&
-            !f.compare( f.length() - sub.first.length(), sub.first.length(), sub.first ) )
+          if (!(wanted & (1u << p)))
+            continue;
+          bool found = false;
+          visit_base_forms(wn, form, pos_t(p), [&](string_ref s)
+            {
+              bases[p] = s;
+              return found = true;
+            });
+          if (found && first_pos)
+            return;
+        }
+        return;
+      }
+
+      auto pos_of = [](list_ref<index> indexes)
+        {
+          pos_mask m = 0;
+          for (const index* it = indexes.begin(); it != indexes.end(); it++)
+            m |= 1u << it->pos;
+          return m;
+        };
+
+      // exceptions: the pos having form among them are settled
+      pos_mask live = 0;
+      pos_mask found = 0;
+      for (std::size_t p = 1; p < POS_ARRAY_SIZE; p++)
+      {
+        if (!(wanted & (1u << p)))
+          continue;
+        list_ref<string_ref> exceptions = wn.exc.find(pos_t(p), form);
+        if (exceptions.empty())
+        {
+          live |= 1u << p;
+          continue;
+        }
+        for (std::size_t i = 0; i < exceptions.size(); i++)
+        {
+          list_ref<index> indexes = wn.find_indexes(exceptions[i]);
+          if (pos_of(indexes) & (1u << p))
           {
-            rules.emplace_back( f.substr( 0, f.length() - sub.first.length() ) + sub.second );
+            bases[p] = indexes.front().lemma;
+            found |= 1u << p;
+            break;
           }
         }
       }
 
-      // filter
-      results.clear();
-      copy_if( forms.begin(), forms.end(), back_inserter(results), copyfilter );
-      copy_if( rules.begin(), rules.end(), back_inserter(results), copyfilter );
+      // known once the pos before the first one found are settled
+      auto decided = [&](pos_mask live)
+        {
+          for (std::size_t p = 1; p < POS_ARRAY_SIZE; p++)
+            if (found & (1u << p))
+              return true;
+            else if (live & (1u << p))
+              return false;
+          return true;
+        };
+      if (!live || (first_pos && decided(live)))
+        return;
+
+      char        small[64];
+      std::string large;
+      char*       buf = small;
+      if (form.size() > sizeof(small))
+      {
+        large.assign(form.begin(), form.end());
+        buf = &large[0];
+      }
+      else
+        std::copy(form.begin(), form.end(), buf);
 
-      if( !results.empty() )
+      morph_walk walk = { wn.morph_all, wn.morph_all_pos.data(), buf, live, 0 };
+      auto visit = [&](string_ref s, pos_mask m)
+        {
+          list_ref<index> indexes = wn.find_indexes(s);
+          pos_mask hits = m & walk.live & pos_of(indexes);
+          if (!hits)
+            return false;
+          for (std::size_t p = 1; p < POS_ARRAY_SIZE; p++)
+            if (hits & (1u << p))
+              bases[p] = indexes.front().lemma;
+          found |= hits;
+          walk.live &= ~hits;
+          return !walk.live || (first_pos && decided(walk.live));
+        };
+
+      // the depths of visit_base_forms, for every live pos
+      for (unsigned depth = 0; ; depth++)
       {
-        return results;
+        walk.reached = 0;
+        if (walk.forms(form.size(), depth, walk.live, visit))
+          return;
+        if (depth == 0) // form goes with the forms one rule away
+          continue;
+        walk.live &= walk.reached;
+        if (!walk.live || (first_pos && decided(walk.live)))
+          return;
       }
+    }
+
+  } // end of anonymous namespace
+
+  // Try to find baseform (lemma) of individual word in POS
+  std::string
+  wordnet::morphword(const std::string& word, pos_t pos) const
+  {
+    return morphword_ref(string_ref(word), pos).to_string();
+  }
+
+  string_ref
+  wordnet::morphword_ref(string_ref word, pos_t pos) const
+  {
+    if (!_morph_cache)
+      return base_form(word, pos);
 
-      //forms = rules;
-      forms.swap( rules );
+    string_ref base;
+    if (!_morph_cache->find(word, pos, base))
+    {
+      base = base_form(word, pos);
+      _morph_cache->insert(word, pos, base);
+    }
+    return base;
+  }
+
+  string_ref
+  wordnet::base_form(string_ref word, pos_t pos) const
+  {
+    string_ref base;
+    auto first = [&base](string_ref s)
+      {
+        base = s;
+        return true;
+      };
+
+    if (morphologicalrules.find(pos) != morphologicalrules.end())
+    {
+      visit_base_forms(*this, word, pos, first);
+      return base;
     }
-    while( !forms.empty() );
 
-    // can't find anything
-    return {};
+    // the first pos having a base form
+    string_ref bases[POS_ARRAY_SIZE];
+    all_base_forms(*this, word, unknown_pos_mask(morphologicalrules), true, bases);
+    for (std::size_t p = 1; p < POS_ARRAY_SIZE; p++)
+      if (!bases[p].empty())
+        return bases[p];
+    return base;
+  }
+
+  void
+  wordnet::morphwords(const std::string& word,
+                      std::string (&bases)[POS_ARRAY_SIZE]) const
+  {
+    pos_mask wanted = 0;
+    for (auto& rules : morphologicalrules)
+      wanted |= 1u << rules.first;
+
+    string_ref found[POS_ARRAY_SIZE];
+    all_base_forms(*this, string_ref(word), wanted & ~1u, false, found);
+
+    // UNKNOWN, and pos without rules (morphed as UNKNOWN)
+    pos_mask any = unknown_pos_mask(morphologicalrules);
+    for (std::size_t p = 1; p < POS_ARRAY_SIZE; p++)
+      if ((any & (1u << p)) && !found[p].empty())
+      {
+        found[pos_t::UNKNOWN] = found[p];
+        break;
+      }
+    for (std::size_t p = 1; p < POS_ARRAY_SIZE; p++)
+      if (!(wanted & (1u << p)))
+        found[p] = found[pos_t::UNKNOWN];
+
+    for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+      bases[p] = found[p].to_string();
   }
 
-  
+  void
+  wordnet::set_morph_cache(std::size_t capacity)
+  {
+    _morph_cache_capacity = capacity;
+    if (capacity == 0)
+      _morph_cache.reset();
+    else
+      _morph_cache.reset(new morph_cache(capacity));
+  }
+
+  morph_cache::statistics
+  wordnet::morph_cache_stats() const
+  {
+    morph_cache::statistics none = { 0, 0, 0 };
+    return _morph_cache ? _morph_cache->stats() : none;
+  }
+
+  void
+  wordnet::warm_morph_cache(const std::vector<std::string>& words)
+  {
+    if (!_morph_cache)
+      return;
+
+    // not counted as hits or misses
+    for (std::size_t i = 0; i < words.size(); i++)
+      for (std::size_t p = 0; p < POS_ARRAY_SIZE; p++)
+        _morph_cache->insert(string_ref(words[i]), (pos_t) p,
+                              base_form(string_ref(words[i]), (pos_t) p));
+  }
+
+  std::vector<std::string>
+  wordnet::_morphword(const std::string &form, pos_t pos) const
+  {
+    morphologicalrules.at(pos); // std::out_of_range for a pos without rules
+
+    std::vector<std::string> results;
+    visit_base_forms(*this, string_ref(form), pos, [&results](string_ref s)
+      {
+        results.push_back(s.to_string());
+        return false;
+      });
+    return results;
+  }
 
 } // end of namespace wnb
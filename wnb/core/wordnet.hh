@@ -6,13 +6,20 @@
 # include <cassert>
 # include <vector>
 #include <map>
+#include <memory>
 //# include <boost/filesystem.hpp>
 
 //Possible https://bugs.launchpad.net/ubuntu/+source/boost/+bug/270873
 # include <boost/graph/graph_traits.hpp>
-# include <boost/graph/adjacency_list.hpp>
+# include <boost/graph/compressed_sparse_row_graph.hpp>
 
 # include "load_wordnet.hh"
+# include "arena.hh"
+# include "mapped_file.hh"
+# include "lemma_table.hh"
+# include "morph_trie.hh"
+# include "morph_cache.hh"
+# include "exception_table.hh"
 # include "pos_t.hh"
 
 namespace wnb
@@ -23,20 +30,22 @@ namespace wnb
   struct info_helper;
 
   /// Synset
+  /// Strings and lists refer to the arena of the wordnet holding the synset
+  /// and are valid as long as this wordnet.
   struct synset
   {
     int  lex_filenum;
     std::size_t  w_cnt;
-    std::vector<std::string> words;
-    std::vector<int> lex_ids;
+    list_ref<string_ref> words;
+    list_ref<int> lex_ids;
     std::size_t p_cnt;
-    std::string gloss;
+    string_ref gloss;
 
     // extra
     pos_t pos;        ///< pos (replace ss_type)
     int id;           ///< unique identifier (replace synset_offset)
     int sense_number; ///< http://wordnet.princeton.edu/man/senseidx.5WN.html
-    std::vector<std::pair<std::string, int> > tag_cnts; ///< http://wordnet.princeton.edu/man/senseidx.5WN.html
+    list_ref<arena::tag_cnt> tag_cnts; ///< http://wordnet.princeton.edu/man/senseidx.5WN.html
 
     bool operator==(const synset& s) const { return (id == s.id);  }
     bool operator<(const synset& s) const { return (id < s.id);   }
@@ -53,20 +62,29 @@ namespace wnb
   };
 
 
-  /// Index
+  /// Edge of the synsets graph, recorded before the graph is built
+  struct graph_edge
+  {
+    unsigned u; ///< source synset
+    unsigned v; ///< target synset
+    ptr      p;
+  };
+
+
+  /// Index (refers to the arena of its wordnet, like synset)
   struct index
   {
-    std::string lemma;
+    string_ref lemma;
 
     std::size_t synset_cnt;
     std::size_t p_cnt;
     std::size_t sense_cnt;
     float       tagsense_cnt;
-    std::vector<std::string> ptr_symbols;
-    std::vector<int>         synset_offsets;
+    list_ref<string_ref> ptr_symbols;
+    list_ref<int>        synset_offsets;
 
     // extra
-    std::vector<int> synset_ids;
+    list_ref<int> synset_ids;
     pos_t pos;
 
     bool operator<(const index& b) const
@@ -76,13 +94,21 @@ namespace wnb
   };
 
 
+  /// Tag selecting the snapshot constructor of wordnet
+  struct from_snapshot_t { };
+  static const from_snapshot_t from_snapshot = from_snapshot_t();
+
   /// Wordnet interface class
   struct wordnet
   {
-    typedef boost::adjacency_list<boost::vecS, boost::vecS,
-                                  boost::directedS,
-                                  synset, ptr> graph; ///< boost graph type
-
+    /// Immutable compressed sparse row graph: targets and edge properties
+    /// are contiguous, out edges of a synset are sorted by pointer symbol.
+    typedef boost::compressed_sparse_row_graph<boost::directedS,
+                                               synset, ptr, boost::no_property,
+                                               unsigned, unsigned> graph; ///< boost graph type
+
+    /// Suffix -> addition, per pos (compiled to morph_tries at construction,
+    /// see compile_morphology)
     std::map< pos_t, std::vector<std::pair<std::string,std::string> > > morphologicalrules
       { {pos_t::N,  { {"s",""}, {"ses","s"}, {"ves","f"}, {"xes","x"}, 
                   {"zes","z"}, {"ches","ch"}, {"shes","sh"}, 
@@ -97,26 +123,110 @@ namespace wnb
     /// Constructor
     wordnet(const std::string& wordnet_dir, bool verbose=false);
 
+    /// Constructor with explicit loading options (e.g. nb_threads)
+    wordnet(const std::string& wordnet_dir, const load_options& options);
+
+    /// Constructor from a file written by save_snapshot
+    wordnet(from_snapshot_t, const std::string& snapshot_file, bool verbose=false);
+
+    /// Copy: synsets and indexes of the copy refer to its own arena, the
+    /// morphword cache (if any) starts empty
+    wordnet(const wordnet& other);
+    wordnet& operator=(const wordnet& other);
+
+    /// Write a binary snapshot of the loaded database (see snapshot.hh)
+    void save_snapshot(const std::string& fn) const;
+
+    /// Gloss of s (a synset of this wordnet)
+    /// With load_options::lazy_glosses, it is found in the mapped data file
+    /// on each call (nothing is copied or cached, safe from any thread),
+    /// std::runtime_error if the file no longer has the synset there.
+    string_ref gloss(const synset& s) const;
+
     /// Return synsets matching word
     std::vector<synset> get_synsets(const std::string& word, pos_t pos = pos_t::UNKNOWN);
+
+    /// Same as get_synsets, appending synset ids (vertices of wordnet_graph)
+    /// to ids instead of copying synsets. Reuse ids between calls to avoid
+    /// allocations (morphing still allocates). Safe from any thread.
+    void get_synset_ids(const std::string& word, std::vector<int>& ids,
+                        pos_t pos = pos_t::UNKNOWN) const;
+
+    /// Same as above for a lemma (no morphing), allocation free once ids
+    /// is large enough
+    void get_lemma_synset_ids(string_ref lemma, std::vector<int>& ids,
+                              pos_t pos = pos_t::UNKNOWN) const;
+
+    /// Synset of id (no copy)
+    const synset& get_synset(int id) const { return wordnet_graph[id]; }
     //FIXME: todo
     std::vector<synset> get_synset(const std::string& word, char pos, int i);
 
     std::pair<std::vector<index>::iterator, std::vector<index>::iterator>
     get_indexes(const std::string& word);
 
-    std::string wordbase(const std::string& word, int ender);
+    /// Entries of index_list for word, one per pos (hash lookup, no allocation)
+    list_ref<index> find_indexes(string_ref word) const;
 
-    std::string morphword(const std::string& word, pos_t pos = pos_t::UNKNOWN);
-    std::vector<std::string> _morphword(const std::string &form, pos_t pos);
+    std::string wordbase(const std::string& word, int ender);
 
-    std::vector<index> index_list;    ///< index list // FIXME: use a map
+    std::string morphword(const std::string& word, pos_t pos = pos_t::UNKNOWN) const;
+
+    /// Same as morphword, as a view of the lemma in this wordnet (empty if
+    /// none): nothing is allocated, through the morphword cache too
+    string_ref morphword_ref(string_ref word, pos_t pos = pos_t::UNKNOWN) const;
+    std::vector<std::string> _morphword(const std::string &form, pos_t pos) const;
+
+    /// Base forms of word in every pos at once: bases[p] is morphword(word, p)
+    /// (bases[UNKNOWN] too), each candidate form being looked up once for
+    /// all pos. The morphword cache is not used.
+    void morphwords(const std::string& word,
+                    std::string (&bases)[POS_ARRAY_SIZE]) const;
+
+    /// Compile morphologicalrules to morph_tries (call again after changing
+    /// the rules). The rules of a pos that cannot be compiled (see
+    /// morph_trie::compilable) are applied one by one, as they were.
+    void compile_morphology();
+
+    /// Memoize morphword in a cache of about capacity (word, pos) pairs,
+    /// words without base form included (0: no cache). Not while other
+    /// threads use this wordnet.
+    void set_morph_cache(std::size_t capacity);
+
+    /// Hits, misses and evictions of the morphword cache (0 without cache)
+    morph_cache::statistics morph_cache_stats() const;
+
+    /// Fill the morphword cache with the base forms of words, for every pos
+    /// (and UNKNOWN), e.g. from the most frequent words of a corpus
+    void warm_morph_cache(const std::vector<std::string>& words);
+
+    /// Load the text database located in wordnet_dir (used by constructors)
+    void load(const std::string& wordnet_dir, const load_options& options);
+
+    /// Replace wordnet_graph by nb_synsets default synsets linked by edges
+    /// (sorted in place by source then pointer symbol, stable)
+    void build_graph(std::size_t nb_synsets, std::vector<graph_edge>& edges);
+
+    std::vector<index> index_list;    ///< index list, sorted by lemma
+    lemma_table        lemmas;        ///< lemma -> entries of index_list
+    morph_trie         morph_tries[POS_ARRAY_SIZE]; ///< compiled morphologicalrules
+    unsigned           morph_by_rule; ///< pos whose rules are not compiled (bit p: pos p)
+    morph_trie         morph_all;     ///< rules of every pos (empty if too many)
+    std::vector<unsigned> morph_all_pos; ///< pos of each rule of morph_all (bit p: pos p)
     graph              wordnet_graph; ///< synsets graph
     info_helper        info;          ///< helper object
+    arena              storage;       ///< strings and lists of synsets/indexes
+    mapped_file        gloss_files[POS_ARRAY_SIZE]; ///< lazy glosses only
     bool               _verbose;
 
-    typedef std::map<std::string,std::vector<std::string> > exc_t;
-    std::map<pos_t, exc_t> exc;
+    exception_table    exc;           ///< morphological exceptions, per pos
+
+  private:
+    /// morphword without cache
+    string_ref base_form(string_ref word, pos_t pos) const;
+
+    std::unique_ptr<morph_cache> _morph_cache; ///< see set_morph_cache
+    std::size_t _morph_cache_capacity;
   };
 
 } // end of namespace wnb
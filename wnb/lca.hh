@@ -0,0 +1,395 @@
+#ifndef _LCA_HH
+# define _LCA_HH
+
+# include <vector>
+# include <algorithm>
+# include <wnb/core/wordnet.hh>
+
+namespace wnb
+{
+
+  /// Lowest common hypernyms of synsets, over the hypernym relation
+  /// (optionally with instance hypernyms).
+  ///
+  /// Synsets with a single hypernym form a forest: pairs in the same tree
+  /// are answered with a sparse table over its preorder. Other pairs (below
+  /// synsets with several hypernyms) merge their sorted ancestor lists.
+  class hypernym_lca
+  {
+  public:
+
+    typedef boost::graph_traits<wordnet::graph>::vertex_descriptor vertex;
+
+    /// Hypernym ancestor and its distance
+    struct ancestor
+    {
+      vertex id;
+      int    distance;
+
+      bool operator<(const ancestor& a) const { return id < a.id; }
+    };
+
+    hypernym_lca(const wordnet::graph& g, bool instances = false);
+
+    /// Hypernym ancestors of s (itself included at distance 0), sorted by id
+    std::pair<const ancestor*, const ancestor*> hypernyms(vertex s) const
+    {
+      const ancestor* a = ancestors.data();
+      return std::make_pair(a + first_ancestor[s], a + first_ancestor[s + 1]);
+    }
+
+    /// Length of the shortest path between u and v through a common
+    /// hypernym, -1 if they have none.
+    int distance(vertex u, vertex v) const
+    {
+      return lowest_common(u, v, 0, -1);
+    }
+
+    /// Same, -1 also if the shortest path is longer than max_distance:
+    /// farther ancestors are skipped
+    int distance(vertex u, vertex v, int max_distance) const
+    {
+      return lowest_common(u, v, 0, max_distance);
+    }
+
+    /// Same as distance, also appending to lchs the common hypernyms on
+    /// the shortest paths.
+    int lowest_common_hypernyms(vertex u, vertex v,
+                                std::vector<vertex>& lchs) const
+    {
+      return lowest_common(u, v, &lchs, -1);
+    }
+
+    /// Distances of u to the synsets (ids) of [b, e), written to dist.
+    /// The ancestors of u are scattered once in scratch, which is resized
+    /// to the number of synsets and left filled with -1 for the next call.
+    void distances(vertex u, const int* b, const int* e, int* dist,
+                   std::vector<int>& scratch) const;
+
+  private:
+
+    bool is_hypernym(int pointer_symbol) const
+    {
+      return pointer_symbol == 1 || (instances && pointer_symbol == 2);
+    }
+
+    void build_ancestors(const wordnet::graph& g);
+    void build_forest(const wordnet::graph& g);
+
+    /// Lowest common ancestor of u and v, in the same tree
+    vertex tree_lca(vertex u, vertex v) const;
+
+    bool same_tree(vertex u, vertex v) const
+    {
+      return root[u] != none && root[u] == root[v];
+    }
+
+    /// u and v are in different trees whose roots have no hypernym
+    bool disjoint_trees(vertex u, vertex v) const
+    {
+      return root[u] != none && root[v] != none
+        && nb_hypernyms[root[u]] == 0 && nb_hypernyms[root[v]] == 0;
+    }
+
+    /// Shortest distance (at most max_distance if not negative) and
+    /// optionally the lowest common hypernyms of u and v
+    int lowest_common(vertex u, vertex v, std::vector<vertex>* lchs,
+                      int max_distance) const;
+
+    /// Lower bound of the distance of u and v, in different trees
+    int min_distance(vertex u, vertex v) const
+    {
+      return (shared[root[u]] ? 0 : depth[u] + 1)
+        + (shared[root[v]] ? 0 : depth[v] + 1);
+    }
+
+    bool instances;
+
+    std::vector<std::size_t> first_ancestor;
+    std::vector<ancestor>    ancestors;
+
+    static const vertex none = vertex(-1);
+    std::vector<unsigned> nb_hypernyms;
+    std::vector<vertex>   parent; ///< single hypernym, none otherwise
+    std::vector<vertex>   root;   ///< root of the tree, none in cycles
+    std::vector<unsigned> depth;  ///< depth in the tree
+    std::vector<unsigned> order;  ///< position in the preorder of the forest
+    /// shared[r]: synsets of other trees have hypernyms in the tree of r
+    /// (otherwise common hypernyms with them are above r)
+    std::vector<bool>     shared;
+    /// table[k][i]: shallowest synset of preorder positions [i, i + 2^k)
+    std::vector<std::vector<vertex> > table;
+  };
+
+
+  inline
+  hypernym_lca::hypernym_lca(const wordnet::graph& g, bool instances)
+    : instances(instances)
+  {
+    build_ancestors(g);
+    build_forest(g);
+  }
+
+
+  inline
+  void
+  hypernym_lca::build_ancestors(const wordnet::graph& g)
+  {
+    std::size_t n = num_vertices(g);
+    std::vector<int>    dist(n, -1);
+    std::vector<vertex> seen; // breadth first queue, then reset list
+
+    first_ancestor.resize(n + 1);
+    ancestors.clear();
+    boost::graph_traits<wordnet::graph>::out_edge_iterator e, e_end;
+    for (vertex s = 0; s < n; s++)
+    {
+      first_ancestor[s] = ancestors.size();
+      seen.clear();
+      seen.push_back(s);
+      dist[s] = 0;
+      for (std::size_t k = 0; k < seen.size(); k++)
+      {
+        vertex u = seen[k];
+        for (boost::tie(e, e_end) = out_edges(u, g); e != e_end; ++e)
+        {
+          vertex v = target(*e, g);
+          if (is_hypernym(g[*e].pointer_symbol) && dist[v] < 0)
+          {
+            dist[v] = dist[u] + 1;
+            seen.push_back(v);
+          }
+        }
+      }
+
+      for (std::size_t k = 0; k < seen.size(); k++)
+      {
+        ancestor a = { seen[k], dist[seen[k]] };
+        ancestors.push_back(a);
+        dist[seen[k]] = -1;
+      }
+      std::sort(ancestors.begin() + first_ancestor[s], ancestors.end());
+    }
+    first_ancestor[n] = ancestors.size();
+  }
+
+
+  inline
+  void
+  hypernym_lca::build_forest(const wordnet::graph& g)
+  {
+    std::size_t n = num_vertices(g);
+    nb_hypernyms.assign(n, 0);
+    parent.assign(n, vertex(none));
+    root.assign(n, vertex(none));
+    depth.assign(n, 0);
+    order.assign(n, 0);
+
+    boost::graph_traits<wordnet::graph>::out_edge_iterator e, e_end;
+    for (vertex u = 0; u < n; u++)
+    {
+      for (boost::tie(e, e_end) = out_edges(u, g); e != e_end; ++e)
+        if (is_hypernym(g[*e].pointer_symbol))
+        {
+          nb_hypernyms[u]++;
+          parent[u] = target(*e, g);
+        }
+      if (nb_hypernyms[u] != 1)
+        parent[u] = none;
+    }
+
+    // children of every synset in the forest
+    std::vector<std::size_t> first_child(n + 1, 0);
+    for (vertex u = 0; u < n; u++)
+      if (parent[u] != none)
+        first_child[parent[u] + 1]++;
+    for (std::size_t i = 0; i < n; i++)
+      first_child[i + 1] += first_child[i];
+    std::vector<vertex>      children(first_child[n]);
+    std::vector<std::size_t> next(first_child.begin(), first_child.end() - 1);
+    for (vertex u = 0; u < n; u++)
+      if (parent[u] != none)
+        children[next[parent[u]]++] = u;
+
+    // preorder of the forest (synsets in cycles are not reached)
+    std::vector<vertex> preorder;
+    std::vector<vertex> stack;
+    preorder.reserve(n);
+    for (vertex r = 0; r < n; r++)
+    {
+      if (parent[r] != none)
+        continue;
+      root[r] = r;
+      stack.push_back(r);
+      while (!stack.empty())
+      {
+        vertex u = stack.back();
+        stack.pop_back();
+        order[u] = preorder.size();
+        preorder.push_back(u);
+        for (std::size_t k = first_child[u]; k < first_child[u + 1]; k++)
+        {
+          vertex c = children[k];
+          root[c]  = r;
+          depth[c] = depth[u] + 1;
+          stack.push_back(c);
+        }
+      }
+    }
+
+    shared.assign(n, false);
+    for (vertex u = 0; u < n; u++)
+      if (nb_hypernyms[u] > 1)
+        for (boost::tie(e, e_end) = out_edges(u, g); e != e_end; ++e)
+        {
+          vertex h = target(*e, g);
+          if (is_hypernym(g[*e].pointer_symbol) && root[h] != none)
+            shared[root[h]] = true;
+        }
+
+    table.clear();
+    table.push_back(preorder);
+    for (std::size_t w = 1; 2 * w <= preorder.size(); w *= 2)
+    {
+      const std::vector<vertex>& prev = table.back();
+      std::vector<vertex> level(preorder.size() - 2 * w + 1);
+      for (std::size_t i = 0; i < level.size(); i++)
+      {
+        vertex a = prev[i], b = prev[i + w];
+        level[i] = (depth[b] < depth[a]) ? b : a;
+      }
+      table.push_back(level);
+    }
+  }
+
+
+  inline
+  hypernym_lca::vertex
+  hypernym_lca::tree_lca(vertex u, vertex v) const
+  {
+    if (u == v)
+      return u;
+
+    // the lca is the parent of the shallowest synset of preorder (u, v]
+    std::size_t b = order[u], e = order[v];
+    if (e < b)
+      std::swap(b, e);
+    b++;
+    e++;
+
+    std::size_t k = 0;
+    while ((std::size_t(2) << k) <= e - b)
+      k++;
+    vertex x = table[k][b], y = table[k][e - (std::size_t(1) << k)];
+    return parent[(depth[y] < depth[x]) ? y : x];
+  }
+
+
+  inline
+  int
+  hypernym_lca::lowest_common(vertex u, vertex v, std::vector<vertex>* lchs,
+                              int max_distance) const
+  {
+    if (same_tree(u, v))
+    {
+      vertex w = tree_lca(u, v);
+      int d = depth[u] + depth[v] - 2 * depth[w];
+      if (max_distance >= 0 && d > max_distance)
+        return -1;
+      if (lchs)
+        lchs->push_back(w);
+      return d;
+    }
+
+    if (disjoint_trees(u, v))
+      return -1;
+    if (max_distance >= 0 && root[u] != none && root[v] != none
+        && min_distance(u, v) > max_distance)
+      return -1;
+
+    std::pair<const ancestor*, const ancestor*> a1 = hypernyms(u);
+    std::pair<const ancestor*, const ancestor*> a2 = hypernyms(v);
+
+    int path_distance = -1;
+    const ancestor* it  = a1.first;
+    const ancestor* it2 = a2.first;
+    std::size_t nb_lchs = lchs ? lchs->size() : 0;
+    while (it != a1.second && it2 != a2.second)
+    {
+      if (it->id < it2->id)
+        ++it;
+      else if (it2->id < it->id)
+        ++it2;
+      else
+      {
+        int new_distance = it->distance + it2->distance;
+        if (max_distance < 0 || new_distance <= max_distance)
+        {
+          if (path_distance < 0 || new_distance < path_distance)
+          {
+            path_distance = new_distance;
+            if (lchs)
+              lchs->resize(nb_lchs);
+          }
+          if (lchs && new_distance == path_distance)
+            lchs->push_back(it->id);
+        }
+        ++it;
+        ++it2;
+      }
+    }
+
+    return path_distance;
+  }
+
+
+  inline
+  void
+  hypernym_lca::distances(vertex u, const int* b, const int* e, int* dist,
+                          std::vector<int>& scratch) const
+  {
+    if (scratch.size() != parent.size())
+      scratch.assign(parent.size(), -1);
+
+    std::pair<const ancestor*, const ancestor*> a1 = hypernyms(u);
+    bool scattered = false;
+    for (; b != e; ++b, ++dist)
+    {
+      vertex v = *b;
+      if (same_tree(u, v))
+      {
+        *dist = depth[u] + depth[v] - 2 * depth[tree_lca(u, v)];
+        continue;
+      }
+      if (disjoint_trees(u, v))
+      {
+        *dist = -1;
+        continue;
+      }
+
+      if (!scattered)
+      {
+        for (const ancestor* it = a1.first; it != a1.second; ++it)
+          scratch[it->id] = it->distance;
+        scattered = true;
+      }
+
+      int path_distance = -1;
+      std::pair<const ancestor*, const ancestor*> a2 = hypernyms(v);
+      for (const ancestor* it = a2.first; it != a2.second; ++it)
+      {
+        int d = scratch[it->id];
+        if (d >= 0 && (path_distance < 0 || d + it->distance < path_distance))
+          path_distance = d + it->distance;
+      }
+      *dist = path_distance;
+    }
+
+    if (scattered)
+      for (const ancestor* it = a1.first; it != a1.second; ++it)
+        scratch[it->id] = -1;
+  }
+
+} // end of namespace wnb
+
+#endif /* _LCA_HH */
@@ -2,6 +2,8 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstdlib>
+#include <chrono>
 
 #include <boost/progress.hpp>
 #include <boost/algorithm/string.hpp>
@@ -9,6 +11,8 @@
 #include <wnb/core/wordnet.hh>
 #include <wnb/core/load_wordnet.hh>
 #include <wnb/core/info_helper.hh>
+#include <wnb/core/scanner.hh>
+#include <wnb/core/run_jobs.hh>
 #include <wnb/nltk_similarity.hh>
 #include <wnb/std_ext.hh>
 
@@ -21,78 +25,58 @@ bool usage(int argc, char ** argv)
   std::string dir;
   if (argc >= 2)
     dir = std::string(argv[1]);
-  if (argc != 3 || dir[dir.length()-1] != '/')
+  bool matrix = (argc == 5 || argc == 6) && std::string(argv[3]) == "matrix";
+  bool lemmatize = (argc == 4 || argc == 5) && std::string(argv[3]) == "lemmatize";
+  if ((argc != 3 && !matrix && !lemmatize) || dir[dir.length()-1] != '/')
   {
     std::cout << argv[0] << " .../wordnet_dir/ word_list_file" << std::endl;
+    std::cout << argv[0] << " .../wordnet_dir/ word_list_file matrix output_file [threads]"
+              << std::endl;
+    std::cout << argv[0] << " .../wordnet_dir/ text_file|- lemmatize [threads]"
+              << std::endl;
     return true;
   }
   return false;
 }
 
-struct ws
-{
-  std::string w;
-  float       s;
-
-  bool operator<(const ws& a) const {return s > a.s;}
-};
-
-
-/// Compute similarity of word with words in word list
-std::vector<ws>
+/// Rank the words of word list by similarity with word, nb_best first, on
+/// nb_threads threads (0: one per core)
+std::vector<word_score>
 compute_similarities(wordnet& wn,
                      const std::string& word,
-                     const std::vector<std::string>& word_list)
+                     const std::vector<std::string>& word_list,
+                     std::size_t nb_best, unsigned nb_threads = 0)
 {
-  std::vector<ws> wslist;
-  std::vector<synset> synsets1 = wn.get_synsets(word);
+  std::vector<int> synsets1;
+  wn.get_synset_ids(word, synsets1);
 
   for (unsigned i = 0; i < synsets1.size(); i++)
-    for (unsigned k = 0; k < synsets1[i].words.size(); k++)
-      std::cout << " - " << synsets1[i].words[k] << std::endl;
-
-  nltk_similarity path_similarity(wn);
   {
-    progress_timer t;
-    progress_display show_progress(word_list.size());
-
-    for (unsigned k = 0; k < word_list.size(); k++)
-    {
-      const std::string& w = word_list[k];
-      float max = 0;
-      std::vector<synset> synsets2 = wn.get_synsets(w);
-      for (unsigned i = 0; i < synsets1.size(); i++)
-      {
-        for (unsigned j = 0; j < synsets2.size(); j++)
-        {
-          float s = path_similarity(synsets1[i], synsets2[j], 6);
-          if (s > max)
-            max = s;
-        }
-      }
-      ws e = {w, max};
-      wslist.push_back(e);
-      ++show_progress;
-    }
+    const synset& s = wn.get_synset(synsets1[i]);
+    for (unsigned k = 0; k < s.words.size(); k++)
+      std::cout << " - " << s.words[k] << std::endl;
   }
 
-  return wslist;
+  nltk_similarity path_similarity(wn);
+  progress_timer t;
+  progress_display show_progress(word_list.size());
+  return rank_words(wn, path_similarity, word, word_list, nb_best, nb_threads,
+                    [&show_progress](std::size_t n) { show_progress += n; });
 }
 
 void similarity_test(wordnet&                  wn,
                      const std::string&        word,
                      std::vector<std::string>& word_list)
 {
-  std::vector<ws> wslist = compute_similarities(wn, word, word_list);
+  std::vector<word_score> wslist = compute_similarities(wn, word, word_list, 10);
 
-  std::stable_sort(wslist.begin(), wslist.end());
-  for (unsigned i = 0; i < std::min(wslist.size(), size_t(10)); i++)
-    std::cout << wslist[i].w << " " << wslist[i].s << std::endl;
+  for (unsigned i = 0; i < wslist.size(); i++)
+    std::cout << wslist[i].word << " " << wslist[i].score << std::endl;
 }
 
 void print_synsets(pos_t pos, wnb::index& idx, wordnet& wn)
 {
-  std::string& mword = idx.lemma;
+  std::string mword = idx.lemma.to_string();
   std::cout << "\nOverview of " << get_name_from_pos(pos) << " " << mword << "\n\n";
   std::cout << "The " << get_name_from_pos(pos) << " " << mword << " has "
             << idx.synset_ids.size() << ((idx.synset_ids.size() == 1) ? " sense": " senses");
@@ -119,10 +103,10 @@ void print_synsets(pos_t pos, wnb::index& idx, wordnet& wn)
 
     std::vector<std::string> nwords;
     for (auto& w : synset.words)
-      nwords.push_back((pos == A) ? w.substr(0, w.find_first_of("(")) : w);
+      nwords.push_back(((pos == A) ? w.substr(0, w.find_first_of("(")) : w).to_string());
 
     std::cout << replace_all_copy(join(nwords, ", "), "_", " ");
-    std::cout << " -- (" << trim_copy(synset.gloss) << ")";
+    std::cout << " -- (" << trim_copy(wn.gloss(synset).to_string()) << ")";
     std::cout << std::endl;
   }
 }
@@ -146,20 +130,106 @@ void wn_like(wordnet& wn, const std::string& word, pos_t pos)
 
 void batch_test(wordnet& wn, std::vector<std::string>& word_list)
 {
+  std::string mwords[POS_ARRAY_SIZE];
   for (std::size_t i = 0; i < word_list.size(); i++)
   {
+    wn.morphwords(word_list[i], mwords);
     for (unsigned p = 1; p < POS_ARRAY_SIZE; p++)
     {
       pos_t pos = (pos_t) p;
 
       wn_like(wn, word_list[i], pos);
-      std::string mword = wn.morphword(word_list[i], pos);
+      const std::string& mword = mwords[p];
       if (mword != word_list[i])
         wn_like(wn, mword, pos);
     }
   }
 }
 
+/// Write a "token\tlemma" line per whitespace separated token of in (the
+/// token itself if it has no base form), in input order, return the
+/// number of tokens. The input is read in blocks, nb_threads blocks at a
+/// time, each lemmatized in place by a thread (0: one per core) into its
+/// own output buffer: memory does not grow with the input. Tokens are
+/// lemmatized in place (morphword_ref, nothing allocated per token), those
+/// as long as a block (1 MiB) are split.
+std::size_t lemmatize_stream(const wordnet& wn, std::istream& in, std::ostream& out,
+                             unsigned nb_threads)
+{
+  const std::size_t block_size = 1 << 20;
+
+  struct block
+  {
+    std::vector<char> text;      ///< whole tokens only
+    std::size_t       size;
+    std::string       lemmas;    ///< output lines
+    std::size_t       nb_tokens;
+  };
+  std::vector<block> blocks(2 * job_threads(std::size_t(-1), nb_threads));
+  std::vector<char>  carry; ///< token cut at the end of the last block read
+
+  std::size_t nb_tokens = 0;
+  bool        eof = false;
+  while (!eof)
+  {
+    std::size_t n = 0;
+    for (; n < blocks.size() && !eof; n++)
+    {
+      block& b = blocks[n];
+      if (b.text.size() < carry.size() + block_size)
+        b.text.resize(carry.size() + block_size);
+      std::copy(carry.begin(), carry.end(), b.text.begin());
+      in.read(&b.text[carry.size()], block_size);
+      std::size_t size = carry.size() + in.gcount();
+      eof = std::size_t(in.gcount()) < block_size;
+
+      // keep the last token for the next block unless it is complete (or
+      // as long as a block: the carry stays shorter than a block)
+      b.size = size;
+      if (!eof)
+      {
+        std::size_t end = size;
+        while (end > 0 && size - end < block_size && !scan::is_space(b.text[end - 1]))
+          end--;
+        if (size - end < block_size)
+          b.size = end;
+      }
+      carry.assign(b.text.begin() + b.size, b.text.begin() + size);
+    }
+
+    run_thread_jobs(n, nb_threads, [&](std::size_t i, unsigned)
+      {
+        block& b = blocks[i];
+        b.lemmas.clear();
+        b.nb_tokens = 0;
+
+        const char* tb;
+        const char* te;
+        scan::fields tokens(b.text.data(), b.text.data() + b.size);
+        while (tokens.token(tb, te))
+        {
+          wnb::string_ref word(tb, te);
+          wnb::string_ref lemma = wn.morphword_ref(word);
+          if (lemma.empty())
+            lemma = word;
+          b.lemmas.append(word.data(), word.size());
+          b.lemmas += '\t';
+          b.lemmas.append(lemma.data(), lemma.size());
+          b.lemmas += '\n';
+          b.nb_tokens++;
+        }
+      });
+
+    for (std::size_t i = 0; i < n; i++)
+    {
+      out.write(blocks[i].lemmas.data(), blocks[i].lemmas.size());
+      nb_tokens += blocks[i].nb_tokens;
+    }
+  }
+  out.flush();
+  return nb_tokens;
+}
+
 int main(int argc, char ** argv)
 {
   if (usage(argc, argv))
@@ -171,10 +241,43 @@ int main(int argc, char ** argv)
 
   wordnet wn(wordnet_dir);
 
+  if (argc > 3 && std::string(argv[3]) == "lemmatize")
+  {
+    std::ios::sync_with_stdio(false);
+    std::ifstream file;
+    if (test_file != "-")
+    {
+      file.open(test_file.c_str(), std::ios::binary);
+      if (!file.is_open())
+        throw std::runtime_error("File not found: " + test_file);
+    }
+
+    // corpora repeat a few thousand forms most of the time
+    wn.set_morph_cache(1 << 16);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::size_t nb_tokens = lemmatize_stream(wn, (test_file == "-") ? std::cin : file,
+                                             std::cout,
+                                             (argc > 4) ? std::atoi(argv[4]) : 0);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << nb_tokens << " tokens, " << s << " s, "
+              << nb_tokens / s << " tokens/s" << std::endl;
+    return 0;
+  }
+
   // read test file
   std::string list = ext::read_file(test_file);
   std::vector<std::string> wl        =  ext::split(list);
 
+  if (argc > 3) // matrix
+  {
+    nltk_similarity path_similarity(wn);
+    progress_timer t;
+    save_similarity_matrix(wn, path_similarity, wl, argv[4],
+                           (argc > 5) ? std::atoi(argv[5]) : 0);
+    std::cout << wl.size() << " x " << wl.size() << " matrix" << std::endl;
+    return 0;
+  }
+
   batch_test(wn, wl);
 }
 
@@ -2,8 +2,18 @@
 # define _NLTK_SIMILARITY_HH
 
 # include <queue>
+# include <vector>
+# include <string>
+# include <algorithm>
+# include <cstring>
+# include <mutex>
+# include <functional>
+# include <boost/cstdint.hpp>
 # include <boost/graph/filtered_graph.hpp>
 # include <wnb/core/wordnet.hh>
+# include <wnb/core/run_jobs.hh>
+# include <wnb/core/mapped_file.hh>
+# include <wnb/lca.hh>
 
 namespace wnb
 {
@@ -11,22 +21,24 @@ namespace wnb
   {
 
     //Helper class filtering out other than hypernym relations
-    template <typename PointerSymbolMap>
+    //(reads the edge bundles of the graph, filtered_graph needs a default
+    // constructible predicate)
+    template <typename Graph>
     struct hyper_edge
     {
-      hyper_edge() { }
+      hyper_edge() : m_graph(0) { }
 
-      hyper_edge(PointerSymbolMap pointer_symbol)
-        : m_pointer_symbol(pointer_symbol) { }
+      hyper_edge(const Graph& g)
+        : m_graph(&g) { }
 
       template <typename Edge>
       bool operator()(const Edge& e) const
       {
-        int p_s = get(m_pointer_symbol, e);
+        int p_s = (*m_graph)[e].pointer_symbol;
         return p_s == 1; // hypernyme (instance_hypernyme not used here)
       }
 
-      PointerSymbolMap m_pointer_symbol;
+      const Graph* m_graph;
     };
 
   } // end of anonymous namespace
@@ -35,35 +47,195 @@ namespace wnb
   class nltk_similarity
   {
 
-    typedef boost::property_map<wordnet::graph,
-                                int ptr::*>::type PointerSymbolMap;
     typedef boost::filtered_graph<wordnet::graph,
-                                  internal::hyper_edge<PointerSymbolMap> > G;
+                                  internal::hyper_edge<wordnet::graph> > G;
     typedef boost::graph_traits<G>::vertex_descriptor vertex;
 
-    internal::hyper_edge<PointerSymbolMap> filter;
+    internal::hyper_edge<wordnet::graph> filter;
     G fg;
+    hypernym_lca lca; // hypernyms only, like fg
 
   public:
 
+    /// Scratch buffers of the batch similarities, one per thread
+    struct buffers
+    {
+      std::vector<int>                    scratch;
+      std::vector<int>                    distances;
+      std::vector<int>                    queue;   ///< most_similar
+      std::vector<hypernym_lca::ancestor> sources; ///< most_similar
+    };
+
+    /// Synset and its similarity with a query synset
+    struct synset_score
+    {
+      int   id;
+      float score;
+    };
+
+  private:
+
+    buffers batch; // used by the non const batch similarities
+
+    /// Hypernym edges reversed: hyponyms[first_hyponym[u], first_hyponym[u + 1])
+    std::vector<std::size_t> first_hyponym;
+    std::vector<vertex>      hyponyms;
+
+    void build_hyponyms(const wordnet::graph& g);
+
+    static float score(int distance)
+    {
+      if (distance >= 0)
+        return 1. / (distance + 1);
+      else
+        return -1;
+    }
+
+  public:
+
+    typedef hypernym_lca::ancestor ancestor;
+
     nltk_similarity(wordnet& wn)
-      : filter(get(&ptr::pointer_symbol, wn.wordnet_graph)),
-                   fg(wn.wordnet_graph, filter)
-    { }
+      : filter(wn.wordnet_graph),
+                   fg(wn.wordnet_graph, filter),
+                   lca(wn.wordnet_graph)
+    {
+      build_hyponyms(wn.wordnet_graph);
+    }
+
+    // Const members may be called from several threads at once.
 
     /// Get list of hypernyms of s along with distance to s
-    std::map<vertex, int> hypernym_map(vertex s);
+    /// (at most max_depth if not 0)
+    std::map<vertex, int> hypernym_map(vertex s, int max_depth = 0) const;
+
+    /// Hypernym ancestors of s (precomputed hypernym_map, sorted by id)
+    std::pair<const ancestor*, const ancestor*> hypernyms(vertex s) const
+    {
+      return lca.hypernyms(s);
+    }
+
+    /// Common hypernyms of synset1 and synset2 on their shortest paths
+    std::vector<synset> lowest_common_hypernyms(const synset& synset1,
+                                                const synset& synset2) const;
+
+    /// Get shortest path between and synset1 and synset2
+    /// (-1 if longer than max_depth, when not 0).
+    int shortest_path_distance(const synset& synset1, const synset& synset2,
+                               int max_depth = 0) const;
+
+    /// return disance (-1 if the path is longer than max_depth, when not 0)
+    float operator()(const synset& synset1, const synset& synset2,
+                     int max_depth = 0) const;
+
+    /// Similarities (as operator()) of every query with every candidate,
+    /// given as synset ids (e.g. from wordnet::get_synset_ids):
+    /// scores[i * candidates.size() + j] for queries[i] and candidates[j]
+    void similarities(const std::vector<int>& queries,
+                      const std::vector<int>& candidates,
+                      std::vector<float>& scores);
+
+    /// Best similarity of every candidate with any of the queries
+    /// (-1 if none)
+    void max_similarities(const std::vector<int>& queries,
+                          const std::vector<int>& candidates,
+                          std::vector<float>& best);
+
+    /// Same as above with the buffers of the calling thread
+    void similarities(const std::vector<int>& queries,
+                      const std::vector<int>& candidates,
+                      std::vector<float>& scores, buffers& b) const;
+    void max_similarities(const std::vector<int>& queries,
+                          const std::vector<int>& candidates,
+                          std::vector<float>& best, buffers& b) const;
+
+    /// The k synsets most similar to s (s excluded), of pos only unless
+    /// UNKNOWN, in decreasing similarity (ties by id). Visits the hyponyms
+    /// of the ancestors of s by increasing distance, up to the distance of
+    /// the k-th synset.
+    void most_similar(const synset& s, std::size_t k,
+                      std::vector<synset_score>& best, pos_t pos = UNKNOWN);
+
+    /// Same as above with the buffers of the calling thread
+    void most_similar(const synset& s, std::size_t k,
+                      std::vector<synset_score>& best, pos_t pos,
+                      buffers& b) const;
 
-    /// Get shortest path between and synset1 and synset2.
-    int shortest_path_distance(const synset& synset1, const synset& synset2);
+  };
 
-    /// return disance
-    float operator()(const synset& synset1, const synset& synset2, int=0);
 
+  /// Word and its best similarity with a query word
+  struct word_score
+  {
+    std::string word;
+    float       score;
+  };
+
+  /// Called with the number of words ranked since the previous call
+  typedef std::function<void(std::size_t)> rank_progress;
+
+  /// Best similarity (0 if none) of every word of word_list with the
+  /// synsets of word, the k best in decreasing order (ties in word_list
+  /// order). Words are spread over nb_threads threads (0: one per core),
+  /// the result does not depend on it. progress (if any) is called after
+  /// each chunk of words, by one thread at a time.
+  std::vector<word_score>
+  rank_words(const wordnet& wn, const nltk_similarity& similarity,
+             const std::string& word, const std::vector<std::string>& word_list,
+             std::size_t k, unsigned nb_threads = 1,
+             const rank_progress& progress = rank_progress());
+
+  /// Best similarity (0 if none) of every pair of words of word_list:
+  /// matrix[i * n + j] for word_list[i] and word_list[j], n being
+  /// word_list.size(). Square tiles of the upper triangle are spread over
+  /// nb_threads threads (0: one per core), each filling its mirror too.
+  void
+  similarity_matrix(const wordnet& wn, const nltk_similarity& similarity,
+                    const std::vector<std::string>& word_list, float* matrix,
+                    unsigned nb_threads = 1);
+
+  /// Header of a similarity matrix file, followed by the n * n floats of
+  /// the matrix (native byte order, see endian_mark)
+  struct similarity_matrix_header
+  {
+    char            magic[8];    ///< "WNBSIMX"
+    boost::uint32_t endian_mark; ///< 0x01020304
+    boost::uint32_t pad;
+    boost::uint64_t nb_words;
   };
 
+  /// Same as similarity_matrix, written to file fn (mapped: the matrix
+  /// may be larger than memory)
+  void
+  save_similarity_matrix(const wordnet& wn, const nltk_similarity& similarity,
+                         const std::vector<std::string>& word_list,
+                         const std::string& fn, unsigned nb_threads = 1);
+
+  inline
+  void
+  nltk_similarity::build_hyponyms(const wordnet::graph& g)
+  {
+    std::size_t n = num_vertices(g);
+    first_hyponym.assign(n + 1, 0);
+
+    boost::graph_traits<wordnet::graph>::edge_iterator e, e_end;
+    for (boost::tie(e, e_end) = edges(g); e != e_end; ++e)
+      if (filter(*e))
+        first_hyponym[target(*e, g) + 1]++;
+    for (std::size_t i = 0; i < n; i++)
+      first_hyponym[i + 1] += first_hyponym[i];
+
+    hyponyms.resize(first_hyponym[n]);
+    std::vector<std::size_t> next(first_hyponym.begin(), first_hyponym.end() - 1);
+    for (boost::tie(e, e_end) = edges(g); e != e_end; ++e)
+      if (filter(*e))
+        hyponyms[next[target(*e, g)]++] = source(*e, g);
+  }
+
+
+  inline
   std::map<nltk_similarity::vertex, int>
-  nltk_similarity::hypernym_map(nltk_similarity::vertex s)
+  nltk_similarity::hypernym_map(nltk_similarity::vertex s, int max_depth) const
   {
     std::map<vertex, int> map;
 
@@ -81,20 +253,16 @@ namespace wnb
       vertex u = q.front(); q.pop();
 
       int new_d = map[u] + 1;
+      if (max_depth > 0 && new_d > max_depth)
+        continue;
       for (boost::tuples::tie(e, e_end) = out_edges(u, fg); e != e_end; ++e)
       {
         vertex v = target(*e,fg);
-        q.push(v);
-
-        if (map.find(v) != map.end())
+        if (map.find(v) == map.end()) // breadth first: first seen is closest
         {
-          if (new_d < map[v])
-            map[v] = new_d;
-          else
-            q.pop();
-        }
-        else
           map[v] = new_d;
+          q.push(v);
+        }
       }
     }
 
@@ -102,41 +270,331 @@ namespace wnb
   }
 
 
-  int
-  nltk_similarity::shortest_path_distance(const synset& synset1, const synset& synset2)
+  inline
+  std::vector<synset>
+  nltk_similarity::lowest_common_hypernyms(const synset& synset1,
+                                           const synset& synset2) const
   {
-    vertex v1 = synset1.id;
-    vertex v2 = synset2.id;
+    std::vector<vertex> ids;
+    lca.lowest_common_hypernyms(synset1.id, synset2.id, ids);
+
+    std::vector<synset> lchs;
+    for (std::size_t i = 0; i < ids.size(); i++)
+      lchs.push_back(fg[ids[i]]);
+    return lchs;
+  }
 
-    std::map<vertex, int> map1 = hypernym_map(v1);
-    std::map<vertex, int> map2 = hypernym_map(v2);
 
+  inline
+  int
+  nltk_similarity::shortest_path_distance(const synset& synset1, const synset& synset2,
+                                          int max_depth) const
+  {
     // For each ancestor synset common to both subject synsets, find the
     // connecting path length. Return the shortest of these.
+    if (max_depth > 0)
+      return lca.distance(synset1.id, synset2.id, max_depth);
+    return lca.distance(synset1.id, synset2.id);
+  }
+
+
+  inline
+  float
+  nltk_similarity::operator()(const synset& synset1, const synset& synset2,
+                              int max_depth) const
+  {
+    return score(shortest_path_distance(synset1, synset2, max_depth));
+  }
+
+
+  inline
+  void
+  nltk_similarity::similarities(const std::vector<int>& queries,
+                                const std::vector<int>& candidates,
+                                std::vector<float>& scores)
+  {
+    similarities(queries, candidates, scores, batch);
+  }
+
+
+  inline
+  void
+  nltk_similarity::similarities(const std::vector<int>& queries,
+                                const std::vector<int>& candidates,
+                                std::vector<float>& scores, buffers& buf) const
+  {
+    std::size_t n = candidates.size();
+    const int* b = candidates.data();
+    scores.resize(queries.size() * n);
+    buf.distances.resize(n);
+    for (std::size_t i = 0; i < queries.size(); i++)
+    {
+      lca.distances(queries[i], b, b + n, buf.distances.data(), buf.scratch);
+      for (std::size_t j = 0; j < n; j++)
+        scores[i * n + j] = score(buf.distances[j]);
+    }
+  }
+
+
+  inline
+  void
+  nltk_similarity::max_similarities(const std::vector<int>& queries,
+                                    const std::vector<int>& candidates,
+                                    std::vector<float>& best)
+  {
+    max_similarities(queries, candidates, best, batch);
+  }
+
+
+  inline
+  void
+  nltk_similarity::max_similarities(const std::vector<int>& queries,
+                                    const std::vector<int>& candidates,
+                                    std::vector<float>& best, buffers& buf) const
+  {
+    std::size_t n = candidates.size();
+    const int* b = candidates.data();
+    best.assign(n, -1);
+    buf.distances.resize(n);
+    for (std::size_t i = 0; i < queries.size(); i++)
+    {
+      lca.distances(queries[i], b, b + n, buf.distances.data(), buf.scratch);
+      for (std::size_t j = 0; j < n; j++)
+        best[j] = std::max(best[j], score(buf.distances[j]));
+    }
+  }
+
+
+  inline
+  void
+  nltk_similarity::most_similar(const synset& s, std::size_t k,
+                                std::vector<synset_score>& best, pos_t pos)
+  {
+    most_similar(s, k, best, pos, batch);
+  }
+
+
+  inline
+  void
+  nltk_similarity::most_similar(const synset& s, std::size_t k,
+                                std::vector<synset_score>& best, pos_t pos,
+                                buffers& buf) const
+  {
+    // Breadth first down the hyponyms, starting from every ancestor at its
+    // distance: synsets are reached at their shortest path distance to s.
+    std::vector<int>&      seen    = buf.scratch; // -1: not reached
+    std::vector<int>&      queue   = buf.queue;   // reached, by distance
+    std::vector<ancestor>& sources = buf.sources;
+    if (seen.size() != first_hyponym.size() - 1)
+      seen.assign(first_hyponym.size() - 1, -1);
+    queue.clear();
+    best.clear();
+
+    std::pair<const ancestor*, const ancestor*> a = lca.hypernyms(s.id);
+    sources.assign(a.first, a.second);
+    std::stable_sort(sources.begin(), sources.end(),
+                     [](const ancestor& x, const ancestor& y)
+                     {
+                       return x.distance < y.distance;
+                     });
+
+    std::size_t head = 0, next_source = 0;
+    for (int d = 0; head < queue.size() || next_source < sources.size(); d++)
+    {
+      // hyponyms of the synsets at distance d - 1, and ancestors at d
+      std::size_t level = queue.size();
+      for (; head < level; head++)
+      {
+        vertex u = queue[head];
+        for (std::size_t i = first_hyponym[u]; i < first_hyponym[u + 1]; i++)
+          if (seen[hyponyms[i]] < 0)
+          {
+            seen[hyponyms[i]] = d;
+            queue.push_back(hyponyms[i]);
+          }
+      }
+      for (; next_source < sources.size()
+             && sources[next_source].distance == d; next_source++)
+        if (seen[sources[next_source].id] < 0)
+        {
+          seen[sources[next_source].id] = d;
+          queue.push_back(sources[next_source].id);
+        }
 
-    int path_distance = -1;
-    std::map<vertex, int>::iterator it, it2;
-    for (it = map1.begin(); it != map1.end(); it++)
-      for (it2 = map2.begin(); it2 != map2.end(); it2++)
-        if (fg[it->first] == fg[it2->first])
+      std::size_t first = best.size();
+      for (std::size_t i = level; i < queue.size(); i++)
+        if (queue[i] != s.id && (pos == UNKNOWN || fg[vertex(queue[i])].pos == pos))
         {
-          int new_distance = it->second + it2->second;
-          if (path_distance < 0 || new_distance < path_distance)
-            path_distance = new_distance;
+          synset_score ss = { queue[i], score(d) };
+          best.push_back(ss);
         }
+      std::sort(best.begin() + first, best.end(),
+                [](const synset_score& x, const synset_score& y)
+                {
+                  return x.id < y.id;
+                });
+      if (best.size() >= k)
+        break;
+    }
 
-    return path_distance;
+    for (std::size_t i = 0; i < queue.size(); i++)
+      seen[queue[i]] = -1;
+    if (best.size() > k)
+      best.resize(k);
   }
 
 
-  float
-  nltk_similarity::operator()(const synset& synset1, const synset& synset2, int)
+  inline
+  std::vector<word_score>
+  rank_words(const wordnet& wn, const nltk_similarity& similarity,
+             const std::string& word, const std::vector<std::string>& word_list,
+             std::size_t k, unsigned nb_threads, const rank_progress& progress)
+  {
+    std::vector<int> queries;
+    wn.get_synset_ids(word, queries);
+
+    // chunks of words, each thread with its own buffers
+    struct worker
+    {
+      nltk_similarity::buffers buf;
+      std::vector<int>         ids;
+      std::vector<std::size_t> first;
+      std::vector<float>       best;
+    };
+    const std::size_t chunk = 256;
+    std::size_t nb_chunks = (word_list.size() + chunk - 1) / chunk;
+    std::vector<worker> workers(job_threads(nb_chunks, nb_threads));
+    std::vector<float>  scores(word_list.size());
+    std::mutex          progress_lock;
+
+    run_thread_jobs(nb_chunks, workers.size(), [&](std::size_t c, unsigned t)
+      {
+        worker& w = workers[t];
+        std::size_t b = c * chunk, e = std::min(b + chunk, word_list.size());
+        w.ids.clear();
+        w.first.clear();
+        for (std::size_t i = b; i < e; i++)
+        {
+          w.first.push_back(w.ids.size());
+          wn.get_synset_ids(word_list[i], w.ids);
+        }
+        w.first.push_back(w.ids.size());
+
+        similarity.max_similarities(queries, w.ids, w.best, w.buf);
+        for (std::size_t i = b; i < e; i++)
+        {
+          float max = 0;
+          for (std::size_t j = w.first[i - b]; j < w.first[i - b + 1]; j++)
+            max = std::max(max, w.best[j]);
+          scores[i] = max;
+        }
+
+        if (progress)
+        {
+          std::lock_guard<std::mutex> guard(progress_lock);
+          progress(e - b);
+        }
+      });
+
+    // k best, ties in word_list order: independent of the threads
+    std::vector<std::size_t> order(word_list.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+      order[i] = i;
+    k = std::min(k, order.size());
+    std::partial_sort(order.begin(), order.begin() + k, order.end(),
+                      [&scores](std::size_t a, std::size_t b)
+                      {
+                        return scores[a] > scores[b]
+                          || (scores[a] == scores[b] && a < b);
+                      });
+
+    std::vector<word_score> ranking;
+    for (std::size_t i = 0; i < k; i++)
+    {
+      word_score ws = { word_list[order[i]], scores[order[i]] };
+      ranking.push_back(ws);
+    }
+    return ranking;
+  }
+
+  inline
+  void
+  similarity_matrix(const wordnet& wn, const nltk_similarity& similarity,
+                    const std::vector<std::string>& word_list, float* matrix,
+                    unsigned nb_threads)
+  {
+    // synsets of every word, resolved once: ids[first[i], first[i + 1])
+    std::size_t n = word_list.size();
+    std::vector<int>         ids;
+    std::vector<std::size_t> first;
+    for (std::size_t i = 0; i < n; i++)
+    {
+      first.push_back(ids.size());
+      wn.get_synset_ids(word_list[i], ids);
+    }
+    first.push_back(ids.size());
+
+    struct worker
+    {
+      nltk_similarity::buffers buf;
+      std::vector<int>         queries;
+      std::vector<int>         columns; ///< synsets of the column words
+      std::vector<float>       best;
+    };
+    const std::size_t tile = 512;
+    std::size_t nb_tiles = (n + tile - 1) / tile;
+    std::size_t nb_jobs  = nb_tiles * (nb_tiles + 1) / 2;
+    std::vector<worker> workers(job_threads(nb_jobs, nb_threads));
+
+    run_thread_jobs(nb_jobs, workers.size(), [&](std::size_t job, unsigned t)
+      {
+        // job-th tile (ti, tj) of the upper triangle, row by row
+        std::size_t ti = 0, tj = job;
+        while (tj >= nb_tiles - ti)
+          tj -= nb_tiles - ti++;
+        tj += ti;
+
+        worker& w = workers[t];
+        std::size_t r0 = ti * tile, r1 = std::min(r0 + tile, n);
+        std::size_t c0 = tj * tile, c1 = std::min(c0 + tile, n);
+        w.columns.assign(ids.begin() + first[c0], ids.begin() + first[c1]);
+
+        for (std::size_t i = r0; i < r1; i++)
+        {
+          w.queries.assign(ids.begin() + first[i], ids.begin() + first[i + 1]);
+          similarity.max_similarities(w.queries, w.columns, w.best, w.buf);
+
+          for (std::size_t j = c0; j < c1; j++)
+          {
+            float max = 0;
+            for (std::size_t k = first[j]; k < first[j + 1]; k++)
+              max = std::max(max, w.best[k - first[c0]]);
+            matrix[i * n + j] = max;
+            matrix[j * n + i] = max;
+          }
+        }
+      });
+  }
+
+
+  inline
+  void
+  save_similarity_matrix(const wordnet& wn, const nltk_similarity& similarity,
+                         const std::vector<std::string>& word_list,
+                         const std::string& fn, unsigned nb_threads)
   {
-    int distance = shortest_path_distance(synset1, synset2);
-    if (distance >= 0)
-      return 1. / (distance + 1);
-    else
-      return -1;
+    std::size_t n = word_list.size();
+    similarity_matrix_header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, "WNBSIMX", 8);
+    h.endian_mark = 0x01020304;
+    h.nb_words    = n;
+
+    mapped_output out(fn, sizeof(h) + n * n * sizeof(float));
+    std::memcpy(out.begin(), &h, sizeof(h));
+    similarity_matrix(wn, similarity, word_list,
+                      reinterpret_cast<float*>(out.begin() + sizeof(h)),
+                      nb_threads);
   }
 
 
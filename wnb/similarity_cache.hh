@@ -0,0 +1,101 @@
+#ifndef _SIMILARITY_CACHE_HH
+# define _SIMILARITY_CACHE_HH
+
+# include <cstddef>
+# include <boost/cstdint.hpp>
+# include <wnb/core/wordnet.hh>
+# include <wnb/core/sharded_lru.hh>
+
+namespace wnb
+{
+
+  /// Bounded, thread safe cache of similarities of synset pairs, in front
+  /// of any measure (nltk_similarity, similarity_measures...).
+  ///
+  /// Keys are ordered pairs of synset ids, kept in a sharded_lru: lookups
+  /// take no lock, lookups and insertions never allocate.
+  template <typename Value = float>
+  class similarity_cache
+  {
+  public:
+
+    /// Counters, summed over the shards
+    struct statistics
+    {
+      std::size_t hits;
+      std::size_t misses;
+      std::size_t evictions;
+    };
+
+    /// Keep (about) capacity pairs, in nb_shards shards (rounded up to a
+    /// power of 2)
+    similarity_cache(std::size_t capacity, std::size_t nb_shards = 16)
+      : _lru(capacity, nb_shards)
+    { }
+
+    /// Similarity of synset1 and synset2: cached, or computed with
+    /// measure(synset1, synset2) (outside of any lock) and cached
+    template <typename Measure>
+    Value operator()(const synset& synset1, const synset& synset2,
+                     const Measure& measure)
+    {
+      Value v;
+      if (find(synset1.id, synset2.id, v))
+        return v;
+      v = measure(synset1, synset2);
+      insert(synset1.id, synset2.id, v);
+      return v;
+    }
+
+    /// Cached similarity of (id1, id2), counted as a hit or a miss
+    bool find(int id1, int id2, Value& v) const
+    {
+      return _lru.find(make_key(id1, id2), v);
+    }
+
+    /// Cache the similarity of (id1, id2), evicting a pair not used
+    /// recently if its set is full
+    void insert(int id1, int id2, Value v)
+    {
+      _lru.insert(make_key(id1, id2), v);
+    }
+
+    /// Number of pairs kept at most (capacity rounded up to whole sets)
+    std::size_t capacity() const { return _lru.capacity(); }
+
+    statistics stats() const
+    {
+      typename lru::statistics s = _lru.stats();
+      statistics st = { s.hits, s.misses, s.evictions };
+      return st;
+    }
+
+    /// Drop every pair (counters are kept)
+    void clear() { _lru.clear(); }
+
+  private:
+
+    typedef boost::uint64_t key_t;
+
+    struct key_hash
+    {
+      boost::uint64_t operator()(key_t key) const
+      {
+        key *= 0x9E3779B97F4A7C15ull;
+        return key ^ (key >> 29);
+      }
+    };
+
+    typedef sharded_lru<key_t, Value, key_hash> lru;
+
+    static key_t make_key(int id1, int id2)
+    {
+      return (key_t(boost::uint32_t(id1)) << 32) | boost::uint32_t(id2);
+    }
+
+    lru _lru;
+  };
+
+} // end of namespace wnb
+
+#endif /* _SIMILARITY_CACHE_HH */
@@ -0,0 +1,440 @@
+#ifndef _SIMILARITY_MEASURES_HH
+# define _SIMILARITY_MEASURES_HH
+
+# include <cmath>
+# include <cstdlib>
+# include <fstream>
+# include <sstream>
+# include <stdexcept>
+# include <string>
+# include <vector>
+# include <algorithm>
+# include <cctype>
+# include <cstdio>
+# include <wnb/core/wordnet.hh>
+# include <wnb/lca.hh>
+
+namespace wnb
+{
+
+  /// Wu-Palmer, Leacock-Chodorow and information content (Resnik, Lin,
+  /// Jiang-Conrath) similarities, computed as NLTK does: over hypernyms and
+  /// instance hypernyms, with a simulated root above the roots of non noun
+  /// synsets. Where NLTK returns None (or raises on different pos), the
+  /// measures return -1. As in NLTK, wup takes the first of the deepest
+  /// common hypernyms by synset name (e.g. dog.n.01).
+  ///
+  /// Depths are precomputed for every synset. The information content
+  /// comes from the tag counts of the wordnet (propagated to hypernyms)
+  /// or from an NLTK ic-*.dat file (load_ic).
+  class similarity_measures
+  {
+  public:
+
+    typedef hypernym_lca::vertex vertex;
+
+    similarity_measures(const wordnet& wn);
+
+    /// Replace the information content by the counts of an ic-*.dat file
+    /// (nouns and verbs, other synsets get no count)
+    void load_ic(const std::string& ic_file);
+
+    /// Length of the shortest/longest hypernym path from s to a root
+    int min_depth(vertex s) const { return min_depths[s]; }
+    int max_depth(vertex s) const { return max_depths[s]; }
+
+    /// -log(p(s)), a huge value (as NLTK) for synsets without counts
+    double information_content(vertex s) const;
+
+    double wup(const synset& synset1, const synset& synset2) const;
+    double lch(const synset& synset1, const synset& synset2) const;
+    double resnik(const synset& synset1, const synset& synset2) const;
+    double lin(const synset& synset1, const synset& synset2) const;
+    double jcn(const synset& synset1, const synset& synset2) const;
+
+  private:
+
+    /// Stands for infinity (NLTK _INF)
+    static double inf() { return 1e300; }
+
+    static bool needs_root(pos_t pos) { return pos != N; }
+
+    /// Index of the counts and max depth of pos (satellites are adjectives)
+    static int pos_bucket(pos_t pos) { return (pos == S) ? A : pos; }
+
+    void build_depths();
+    void count_tags();
+
+    /// NLTK name of s: first word (lowercase), pos, sense number in the
+    /// index entry of that word, e.g. dog.n.01
+    std::string synset_name(vertex s) const;
+
+    /// shortest_path_distance, optionally through the simulated root
+    int path_distance(vertex u, vertex v, bool simulate_root) const;
+
+    /// Information content of synset1 and synset2, and the highest of
+    /// their common hypernyms (0 if none), false on different pos
+    bool lcs_ic(const synset& synset1, const synset& synset2,
+                double& ic1, double& ic2, double& ic_lcs) const;
+
+    const wordnet&        wn;
+    const wordnet::graph& g;
+    const info_helper&    info;
+    hypernym_lca          lca; // with instance hypernyms
+
+    std::vector<int> min_depths;
+    std::vector<int> max_depths;
+    std::vector<int> heights;    ///< longest of the shortest paths to an ancestor
+    int              pos_depths[POS_ARRAY_SIZE]; ///< max of max_depths per pos
+
+    std::vector<double> counts;  ///< synset counts (with hyponyms counts)
+    double              root_counts[POS_ARRAY_SIZE];
+  };
+
+
+  inline
+  similarity_measures::similarity_measures(const wordnet& wn)
+    : wn(wn), g(wn.wordnet_graph), info(wn.info), lca(wn.wordnet_graph, true)
+  {
+    build_depths();
+    count_tags();
+  }
+
+
+  inline
+  void
+  similarity_measures::build_depths()
+  {
+    std::size_t n = num_vertices(g);
+    min_depths.assign(n, 0);
+    max_depths.assign(n, 0);
+    heights.assign(n, 0);
+    std::fill(pos_depths, pos_depths + POS_ARRAY_SIZE, 0);
+
+    // depth first, hypernyms before their hyponyms (edges closing a cycle
+    // are ignored)
+    enum { unseen, visiting, finished };
+    std::vector<char>   state(n, unseen);
+    std::vector<vertex> stack;
+    boost::graph_traits<wordnet::graph>::out_edge_iterator e, e_end;
+    for (vertex s = 0; s < n; s++)
+    {
+      stack.push_back(s);
+      while (!stack.empty())
+      {
+        vertex u = stack.back();
+        if (state[u] == unseen)
+        {
+          state[u] = visiting;
+          for (boost::tie(e, e_end) = out_edges(u, g); e != e_end; ++e)
+          {
+            int p = g[*e].pointer_symbol;
+            if ((p == 1 || p == 2) && state[target(*e, g)] == unseen)
+              stack.push_back(target(*e, g));
+          }
+          continue;
+        }
+        stack.pop_back();
+        if (state[u] == finished)
+          continue;
+
+        bool first = true;
+        for (boost::tie(e, e_end) = out_edges(u, g); e != e_end; ++e)
+        {
+          int p = g[*e].pointer_symbol;
+          vertex h = target(*e, g);
+          if ((p != 1 && p != 2) || state[h] != finished)
+            continue;
+          if (first || min_depths[h] + 1 < min_depths[u])
+            min_depths[u] = min_depths[h] + 1;
+          max_depths[u] = std::max(max_depths[u], max_depths[h] + 1);
+          first = false;
+        }
+        state[u] = finished;
+      }
+    }
+
+    for (vertex s = 0; s < n; s++)
+    {
+      std::pair<const hypernym_lca::ancestor*,
+                const hypernym_lca::ancestor*> a = lca.hypernyms(s);
+      for (; a.first != a.second; ++a.first)
+        heights[s] = std::max(heights[s], a.first->distance);
+
+      int b = pos_bucket(g[s].pos);
+      pos_depths[b] = std::max(pos_depths[b], max_depths[s]);
+    }
+  }
+
+
+  inline
+  void
+  similarity_measures::count_tags()
+  {
+    std::size_t n = num_vertices(g);
+    counts.assign(n, 0);
+    std::fill(root_counts, root_counts + POS_ARRAY_SIZE, 0);
+
+    // every tagged synset counts for each of its hypernyms (once)
+    for (vertex s = 0; s < n; s++)
+    {
+      double c = 0;
+      for (std::size_t i = 0; i < g[s].tag_cnts.size(); i++)
+        c += g[s].tag_cnts[i].second;
+      if (c == 0)
+        continue;
+
+      root_counts[pos_bucket(g[s].pos)] += c;
+      std::pair<const hypernym_lca::ancestor*,
+                const hypernym_lca::ancestor*> a = lca.hypernyms(s);
+      for (; a.first != a.second; ++a.first)
+        counts[a.first->id] += c;
+    }
+  }
+
+
+  inline
+  void
+  similarity_measures::load_ic(const std::string& ic_file)
+  {
+    std::ifstream fin(ic_file.c_str());
+    if (!fin.is_open())
+      throw std::runtime_error("File Not Found: " + ic_file);
+
+    std::vector<double> file_counts(num_vertices(g), 0);
+    double              file_roots[POS_ARRAY_SIZE] = { 0 };
+
+    std::string line;
+    std::getline(fin, line); // wnver::...
+    while (std::getline(fin, line))
+    {
+      if (line.find_first_not_of(" \t\r") == std::string::npos)
+        continue;
+
+      // <offset><pos> <count> [ROOT]
+      std::istringstream fields(line);
+      std::string id, root;
+      double count;
+      if (!(fields >> id >> count) || id.size() < 2)
+        throw std::runtime_error("Bad ic line: " + line);
+      fields >> root;
+
+      pos_t pos = get_pos_from_char(id[id.size() - 1]);
+      int u = info.compute_indice(std::atoi(id.c_str()), pos);
+      if (u < 0)
+        throw std::runtime_error("Unknown synset in ic file: " + id);
+
+      if (root == "ROOT")
+        file_roots[pos_bucket(pos)] += count;
+      file_counts[u] = count;
+    }
+
+    counts.swap(file_counts);
+    std::copy(file_roots, file_roots + POS_ARRAY_SIZE, root_counts);
+  }
+
+
+  inline
+  double
+  similarity_measures::information_content(vertex s) const
+  {
+    double c = counts[s];
+    if (c == 0)
+      return inf();
+    return -std::log(c / root_counts[pos_bucket(g[s].pos)]);
+  }
+
+
+  inline
+  std::string
+  similarity_measures::synset_name(vertex s) const
+  {
+    // without syntactic marker, e.g. galore(ip)
+    string_ref word = g[s].words.front();
+    std::size_t marker = word.find('(');
+    if (marker != string_ref::npos && word.back() == ')')
+      word = word.substr(0, marker);
+    std::string lemma = word.to_string();
+    for (std::size_t i = 0; i < lemma.size(); i++)
+      lemma[i] = std::tolower(static_cast<unsigned char>(lemma[i]));
+
+    // satellites are numbered in the adjective entry
+    int sense = 0;
+    list_ref<index> entries = wn.find_indexes(string_ref(lemma));
+    for (const index* e = entries.begin(); e != entries.end(); ++e)
+      if (e->pos == pos_bucket(g[s].pos))
+        for (std::size_t i = 0; i < e->synset_ids.size(); i++)
+          if (e->synset_ids[i] == static_cast<int>(s))
+            sense = i + 1;
+
+    char suffix[16];
+    std::snprintf(suffix, sizeof (suffix), ".%c.%02d", POS_ARRAY[g[s].pos], sense);
+    return lemma + suffix;
+  }
+
+
+  inline
+  int
+  similarity_measures::path_distance(vertex u, vertex v, bool simulate_root) const
+  {
+    int distance = lca.distance(u, v);
+    if (!simulate_root)
+      return distance;
+
+    // the simulated root is one above the farthest hypernym
+    int root_distance = heights[u] + 1 + heights[v] + 1;
+    if (distance < 0 || root_distance < distance)
+      return root_distance;
+    return distance;
+  }
+
+
+  inline
+  double
+  similarity_measures::wup(const synset& synset1, const synset& synset2) const
+  {
+    vertex u = synset1.id, v = synset2.id;
+    bool simulate_root = needs_root(synset1.pos);
+
+    // subsumer: common hypernym with the largest min depth (synset1 first,
+    // then the first by name among equals)
+    std::pair<const hypernym_lca::ancestor*,
+              const hypernym_lca::ancestor*> a1 = lca.hypernyms(u);
+    std::pair<const hypernym_lca::ancestor*,
+              const hypernym_lca::ancestor*> a2 = lca.hypernyms(v);
+    int    best = -1;
+    vertex subsumer = 0;
+    while (a1.first != a1.second && a2.first != a2.second)
+    {
+      if (a1.first->id < a2.first->id)
+        ++a1.first;
+      else if (a2.first->id < a1.first->id)
+        ++a2.first;
+      else
+      {
+        vertex a = a1.first->id;
+        if (min_depths[a] > best
+            || (min_depths[a] == best && subsumer != u
+                && (a == u || synset_name(a) < synset_name(subsumer))))
+        {
+          best = min_depths[a];
+          subsumer = a;
+        }
+        ++a1.first;
+        ++a2.first;
+      }
+    }
+
+    // the simulated root (min depth 0) sorts first among roots in NLTK
+    if (simulate_root && best <= 0 && !(best == 0 && subsumer == u))
+    {
+      double depth = 1;
+      return 2 * depth / (heights[u] + 1 + depth + heights[v] + 1 + depth);
+    }
+    if (best < 0)
+      return -1;
+
+    double depth = max_depths[subsumer] + 1;
+    double len1  = path_distance(u, subsumer, simulate_root) + depth;
+    double len2  = path_distance(v, subsumer, simulate_root) + depth;
+    return 2 * depth / (len1 + len2);
+  }
+
+
+  inline
+  double
+  similarity_measures::lch(const synset& synset1, const synset& synset2) const
+  {
+    if (synset1.pos != synset2.pos)
+      return -1;
+
+    bool simulate_root = needs_root(synset1.pos);
+    int  depth = pos_depths[pos_bucket(synset1.pos)] + (simulate_root ? 1 : 0);
+    int  distance = path_distance(synset1.id, synset2.id, simulate_root);
+    if (distance < 0 || depth == 0)
+      return -1;
+    return -std::log((distance + 1) / (2.0 * depth));
+  }
+
+
+  inline
+  bool
+  similarity_measures::lcs_ic(const synset& synset1, const synset& synset2,
+                              double& ic1, double& ic2, double& ic_lcs) const
+  {
+    if (synset1.pos != synset2.pos)
+      return false;
+
+    ic1 = information_content(synset1.id);
+    ic2 = information_content(synset2.id);
+
+    ic_lcs = 0;
+    bool found = false;
+    std::pair<const hypernym_lca::ancestor*,
+              const hypernym_lca::ancestor*> a1 = lca.hypernyms(synset1.id);
+    std::pair<const hypernym_lca::ancestor*,
+              const hypernym_lca::ancestor*> a2 = lca.hypernyms(synset2.id);
+    while (a1.first != a1.second && a2.first != a2.second)
+    {
+      if (a1.first->id < a2.first->id)
+        ++a1.first;
+      else if (a2.first->id < a1.first->id)
+        ++a2.first;
+      else
+      {
+        double ic = information_content(a1.first->id);
+        if (!found || ic > ic_lcs)
+          ic_lcs = ic;
+        found = true;
+        ++a1.first;
+        ++a2.first;
+      }
+    }
+    return true;
+  }
+
+
+  inline
+  double
+  similarity_measures::resnik(const synset& synset1, const synset& synset2) const
+  {
+    double ic1, ic2, ic_lcs;
+    if (!lcs_ic(synset1, synset2, ic1, ic2, ic_lcs))
+      return -1;
+    return ic_lcs;
+  }
+
+
+  inline
+  double
+  similarity_measures::lin(const synset& synset1, const synset& synset2) const
+  {
+    double ic1, ic2, ic_lcs;
+    if (!lcs_ic(synset1, synset2, ic1, ic2, ic_lcs))
+      return -1;
+    return (2.0 * ic_lcs) / (ic1 + ic2);
+  }
+
+
+  inline
+  double
+  similarity_measures::jcn(const synset& synset1, const synset& synset2) const
+  {
+    if (synset1.id == synset2.id)
+      return inf();
+
+    double ic1, ic2, ic_lcs;
+    if (!lcs_ic(synset1, synset2, ic1, ic2, ic_lcs))
+      return -1;
+    if (ic1 == 0 || ic2 == 0)
+      return 0;
+
+    double ic_difference = ic1 + ic2 - 2 * ic_lcs;
+    if (ic_difference == 0)
+      return inf();
+    return 1 / ic_difference;
+  }
+
+} // end of namespace wnb
+
+#endif /* _SIMILARITY_MEASURES_HH */